@@ -1,27 +1,57 @@
+#include <algorithm>
 #include <array>
+#include <cerrno>
 #include <chrono>
 #include <cctype>
 #include <cstdint>
 #include <cstdio>
 #include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <exception>
 #include <filesystem>
+#include <fstream>
+#include <functional>
 #include <iomanip>
 #include <iostream>
+#include <limits>
 #include <memory>
+#include <mutex>
 #include <random>
 #include <sstream>
 #include <stdexcept>
 #include <string>
 #include <string_view>
+#include <thread>
+#include <unordered_map>
 #include <vector>
 
+#include <rocksdb/block_cache_trace_writer.h>
 #include <rocksdb/cache.h>
 #include <rocksdb/db.h>
+#include <rocksdb/filter_policy.h>
+#include <rocksdb/iostats_context.h>
+#include <rocksdb/memory_allocator.h>
+#include <rocksdb/metadata.h>
 #include <rocksdb/options.h>
+#include <rocksdb/perf_context.h>
 #include <rocksdb/slice.h>
+#include <rocksdb/statistics.h>
 #include <rocksdb/table.h>
+#include <rocksdb/table_properties.h>
+#include <rocksdb/utilities/checkpoint.h>
 #include <rocksdb/write_batch.h>
 
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#endif
+
 namespace {
 
 constexpr uint64_t kRawPayloadBytes = 4ull * 1024ull * 1024ull * 1024ull;
@@ -31,11 +61,104 @@ constexpr size_t kEntryBytes = kKeySize + kValueSize;
 static_assert(kRawPayloadBytes % kEntryBytes == 0, "payload must be divisible by entry size");
 constexpr uint64_t kEntryCount = kRawPayloadBytes / kEntryBytes;  // 33,554,432 entries.
 
+enum class InsertOrder { kSorted, kRandom, kReverse, kInterleaved };
+enum class DeleteKind { kPoint, kSingle, kRange };
+enum class CacheAllocator { kDefault, kThp, kHugetlb };
+
 struct Config {
   std::vector<int> block_sizes;
   std::filesystem::path db_root = std::filesystem::path{"./space_amp_runs"};
   bool keep_dbs = false;
   uint64_t read_ops = 200'000;
+  bool buffered_reads = false;
+  bool page_cache_residency = false;
+  bool cache_trace = false;
+  std::filesystem::path simulate_trace;
+  std::vector<uint64_t> cache_sizes;
+  bool warmup = false;
+  uint64_t warmup_cache_bytes = 1024ull * 1024ull * 1024ull;
+  bool advise = false;
+  uint64_t memory_budget = 1024ull * 1024ull * 1024ull;
+  size_t key_size = kKeySize;
+  size_t value_size = kValueSize;
+  uint64_t dataset_bytes = kRawPayloadBytes;
+  double scan_fraction = 0.0;
+  double absent_fraction = 0.0;
+  std::string device = "nvme";
+  double target_ops = 0.0;
+  uint64_t trial_entries = 1'000'000;
+  int restart_interval = 16;
+  rocksdb::BlockBasedTableOptions::IndexShorteningMode index_shortening =
+      rocksdb::BlockBasedTableOptions::IndexShorteningMode::kShortenSeparators;
+  double compression_ratio = 1.0;
+  bool predict_only = false;
+  bool udt = false;
+  InsertOrder insert_order = InsertOrder::kSorted;
+  int load_threads = 1;
+  double delete_fraction = 0.0;
+  std::vector<DeleteKind> delete_kinds = {DeleteKind::kPoint, DeleteKind::kSingle, DeleteKind::kRange};
+  std::vector<int> scan_threads;
+  std::vector<CacheAllocator> cache_allocators;
+  uint64_t block_cache_bytes = 0;  // 0 sizes the cache from the SST set, see CacheAllocatorCapacity.
+};
+
+// Page-cache footprint of the SST files, split at the boundary between the data blocks and the
+// index/filter/meta blocks that trail them.
+struct ResidencyStats {
+  uint64_t data_bytes = 0;
+  uint64_t data_resident_bytes = 0;
+  uint64_t meta_bytes = 0;
+  uint64_t meta_resident_bytes = 0;
+
+  uint64_t ResidentBytes() const { return data_resident_bytes + meta_resident_bytes; }
+};
+
+// Recovery after a reopen with an empty block cache, for one warm-up strategy.
+struct WarmupStats {
+  std::string strategy;
+  double warmup_seconds = 0.0;
+  uint64_t warmup_bytes_read = 0;
+  uint64_t cache_bytes_after_warmup = 0;
+  double first_window_hit_ratio = 0.0;
+  double steady_hit_ratio = 0.0;
+  double steady_ops_per_sec = 0.0;
+  double seconds_to_steady = 0.0;
+};
+
+// Cost of one delete style over the deleted region, measured after a flush (tombstones still
+// present) and again after a full compaction has dropped them.
+struct DeleteStats {
+  DeleteKind kind = DeleteKind::kPoint;
+  double delete_seconds = 0.0;
+  uint64_t sst_bytes_before = 0;
+  uint64_t sst_bytes_after = 0;
+  double get_us_before = 0.0;
+  double get_us_after = 0.0;
+  double scan_us_before = 0.0;
+  double scan_us_after = 0.0;
+  double skipped_per_scan_before = 0.0;
+  double skipped_per_scan_after = 0.0;
+  double compaction_seconds = 0.0;
+};
+
+// Cached random-read throughput with the block cache's memory coming from one allocator.
+// dtlb_misses_per_op is negative when the dTLB counter could not be opened.
+struct AllocatorStats {
+  std::string allocator;
+  double ops_per_sec = 0.0;
+  double hit_ratio = 0.0;
+  double dtlb_misses_per_op = -1.0;
+  uint64_t cache_bytes = 0;
+  uint64_t arena_bytes = 0;
+  uint64_t fallback_chunks = 0;
+  uint64_t malloc_fallbacks = 0;
+};
+
+struct ScanStats {
+  int threads = 0;
+  double seconds = 0.0;
+  uint64_t rows = 0;
+  uint64_t bytes = 0;
 };
 
 struct Result {
@@ -45,6 +168,18 @@ struct Result {
   uint64_t table_readers_mem = 0;
   double amplification = 0.0;
   double read_ops_per_sec = 0.0;
+  ResidencyStats residency_before;
+  ResidencyStats residency_after;
+  std::filesystem::path cache_trace_path;
+  std::vector<WarmupStats> warmup;
+  uint64_t data_bytes = 0;
+  uint64_t index_bytes = 0;
+  double ingest_seconds = 0.0;
+  double write_amplification = 0.0;
+  std::string ingest_layout;
+  std::vector<DeleteStats> deletes;
+  std::vector<ScanStats> scans;
+  std::vector<AllocatorStats> allocators;
 };
 
 std::string HumanBytes(double bytes) {
@@ -64,24 +199,32 @@ std::vector<int> DefaultBlockSizes() {
   return {4 * 1024, 8 * 1024, 16 * 1024, 32 * 1024, 64 * 1024};
 }
 
-std::vector<int> ParseBlockSizes(std::string_view csv) {
-  if (csv.empty()) {
-    return DefaultBlockSizes();
-  }
-  std::vector<int> values;
-  std::string current;
-  for (char c : csv) {
-    if (c == ',') {
-      if (!current.empty()) {
-        values.push_back(std::stoi(current));
-        current.clear();
-      }
-    } else if (!std::isspace(static_cast<unsigned char>(c))) {
-      current.push_back(c);
+// Splits a comma-separated flag value into its entries, trimming whitespace around each one and
+// dropping empty ones.
+std::vector<std::string> SplitCsv(std::string_view csv) {
+  std::vector<std::string> entries;
+  size_t begin = 0;
+  while (begin <= csv.size()) {
+    size_t end = std::min(csv.find(',', begin), csv.size());
+    const size_t next = end + 1;
+    while (begin < end && std::isspace(static_cast<unsigned char>(csv[begin]))) {
+      ++begin;
+    }
+    while (end > begin && std::isspace(static_cast<unsigned char>(csv[end - 1]))) {
+      --end;
     }
+    if (end > begin) {
+      entries.emplace_back(csv.substr(begin, end - begin));
+    }
+    begin = next;
   }
-  if (!current.empty()) {
-    values.push_back(std::stoi(current));
+  return entries;
+}
+
+std::vector<int> ParseBlockSizes(std::string_view csv) {
+  std::vector<int> values;
+  for (const std::string& entry : SplitCsv(csv)) {
+    values.push_back(std::stoi(entry));
   }
   if (values.empty()) {
     values = DefaultBlockSizes();
@@ -89,6 +232,131 @@ std::vector<int> ParseBlockSizes(std::string_view csv) {
   return values;
 }
 
+std::vector<int> ParseThreadCounts(std::string_view csv) {
+  std::vector<int> values;
+  for (const std::string& entry : SplitCsv(csv)) {
+    values.push_back(std::max(1, std::stoi(entry)));
+  }
+  return values;
+}
+
+std::vector<uint64_t> DefaultCacheSizes() {
+  std::vector<uint64_t> sizes;
+  for (uint64_t size = 4ull * 1024ull * 1024ull; size <= 4ull * 1024ull * 1024ull * 1024ull; size *= 4) {
+    sizes.push_back(size);
+  }
+  return sizes;
+}
+
+std::vector<uint64_t> ParseCacheSizes(std::string_view csv) {
+  std::vector<uint64_t> values;
+  for (const std::string& entry : SplitCsv(csv)) {
+    values.push_back(std::stoull(entry));
+  }
+  std::sort(values.begin(), values.end());
+  return values;
+}
+
+rocksdb::BlockBasedTableOptions::IndexShorteningMode ParseIndexShortening(std::string_view name) {
+  using Mode = rocksdb::BlockBasedTableOptions::IndexShorteningMode;
+  if (name == "none") {
+    return Mode::kNoShortening;
+  }
+  if (name == "separators") {
+    return Mode::kShortenSeparators;
+  }
+  if (name == "all") {
+    return Mode::kShortenSeparatorsAndSuccessor;
+  }
+  throw std::runtime_error("Unknown --index_shortening mode: " + std::string(name));
+}
+
+InsertOrder ParseInsertOrder(std::string_view name) {
+  if (name == "sorted") {
+    return InsertOrder::kSorted;
+  }
+  if (name == "random") {
+    return InsertOrder::kRandom;
+  }
+  if (name == "reverse") {
+    return InsertOrder::kReverse;
+  }
+  if (name == "interleaved") {
+    return InsertOrder::kInterleaved;
+  }
+  throw std::runtime_error("Unknown --insert_order: " + std::string(name));
+}
+
+const char* InsertOrderName(InsertOrder order) {
+  switch (order) {
+    case InsertOrder::kSorted:
+      return "sorted";
+    case InsertOrder::kRandom:
+      return "random";
+    case InsertOrder::kReverse:
+      return "reverse";
+    case InsertOrder::kInterleaved:
+      return "interleaved";
+  }
+  return "unknown";
+}
+
+const char* DeleteKindName(DeleteKind kind) {
+  switch (kind) {
+    case DeleteKind::kPoint:
+      return "Delete";
+    case DeleteKind::kSingle:
+      return "SingleDelete";
+    case DeleteKind::kRange:
+      return "DeleteRange";
+  }
+  return "unknown";
+}
+
+std::vector<DeleteKind> ParseDeleteKinds(std::string_view csv) {
+  std::vector<DeleteKind> kinds;
+  for (const std::string& entry : SplitCsv(csv)) {
+    if (entry == "point") {
+      kinds.push_back(DeleteKind::kPoint);
+    } else if (entry == "single") {
+      kinds.push_back(DeleteKind::kSingle);
+    } else if (entry == "range") {
+      kinds.push_back(DeleteKind::kRange);
+    } else {
+      throw std::runtime_error("Unknown delete kind: " + entry);
+    }
+  }
+  return kinds;
+}
+
+const char* CacheAllocatorName(CacheAllocator allocator) {
+  switch (allocator) {
+    case CacheAllocator::kDefault:
+      return "default";
+    case CacheAllocator::kThp:
+      return "thp";
+    case CacheAllocator::kHugetlb:
+      return "hugetlb";
+  }
+  return "unknown";
+}
+
+std::vector<CacheAllocator> ParseCacheAllocators(std::string_view csv) {
+  std::vector<CacheAllocator> allocators;
+  for (const std::string& entry : SplitCsv(csv)) {
+    if (entry == "default") {
+      allocators.push_back(CacheAllocator::kDefault);
+    } else if (entry == "thp") {
+      allocators.push_back(CacheAllocator::kThp);
+    } else if (entry == "hugetlb") {
+      allocators.push_back(CacheAllocator::kHugetlb);
+    } else {
+      throw std::runtime_error("Unknown cache allocator: " + entry);
+    }
+  }
+  return allocators;
+}
+
 Config ParseArguments(int argc, char** argv) {
   Config cfg;
   for (int i = 1; i < argc; ++i) {
@@ -102,8 +370,81 @@ Config ParseArguments(int argc, char** argv) {
     } else if (arg.rfind("--read_ops=", 0) == 0) {
       std::string_view value = arg.substr(std::string_view("--read_ops=").size());
       cfg.read_ops = std::stoull(std::string(value));
+    } else if (arg == "--buffered_reads") {
+      cfg.buffered_reads = true;
+    } else if (arg == "--page_cache_residency") {
+      cfg.buffered_reads = true;
+      cfg.page_cache_residency = true;
+    } else if (arg == "--cache_trace") {
+      cfg.cache_trace = true;
+    } else if (arg.rfind("--simulate_trace=", 0) == 0) {
+      cfg.simulate_trace = std::string(arg.substr(std::string_view("--simulate_trace=").size()));
+    } else if (arg.rfind("--cache_sizes=", 0) == 0) {
+      cfg.cache_sizes = ParseCacheSizes(arg.substr(std::string_view("--cache_sizes=").size()));
+    } else if (arg == "--warmup") {
+      cfg.warmup = true;
+    } else if (arg.rfind("--warmup_cache_bytes=", 0) == 0) {
+      std::string_view value = arg.substr(std::string_view("--warmup_cache_bytes=").size());
+      cfg.warmup_cache_bytes = std::stoull(std::string(value));
+    } else if (arg == "--advise") {
+      cfg.advise = true;
+    } else if (arg.rfind("--memory_budget=", 0) == 0) {
+      cfg.memory_budget = std::stoull(std::string(arg.substr(std::string_view("--memory_budget=").size())));
+    } else if (arg.rfind("--key_size=", 0) == 0) {
+      cfg.key_size = std::stoul(std::string(arg.substr(std::string_view("--key_size=").size())));
+    } else if (arg.rfind("--value_size=", 0) == 0) {
+      cfg.value_size = std::stoul(std::string(arg.substr(std::string_view("--value_size=").size())));
+    } else if (arg.rfind("--dataset_bytes=", 0) == 0) {
+      cfg.dataset_bytes = std::stoull(std::string(arg.substr(std::string_view("--dataset_bytes=").size())));
+    } else if (arg.rfind("--scan_fraction=", 0) == 0) {
+      cfg.scan_fraction = std::stod(std::string(arg.substr(std::string_view("--scan_fraction=").size())));
+    } else if (arg.rfind("--absent_fraction=", 0) == 0) {
+      cfg.absent_fraction = std::stod(std::string(arg.substr(std::string_view("--absent_fraction=").size())));
+    } else if (arg.rfind("--device=", 0) == 0) {
+      cfg.device = std::string(arg.substr(std::string_view("--device=").size()));
+    } else if (arg.rfind("--target_ops=", 0) == 0) {
+      cfg.target_ops = std::stod(std::string(arg.substr(std::string_view("--target_ops=").size())));
+    } else if (arg.rfind("--trial_entries=", 0) == 0) {
+      cfg.trial_entries = std::stoull(std::string(arg.substr(std::string_view("--trial_entries=").size())));
+    } else if (arg.rfind("--restart_interval=", 0) == 0) {
+      cfg.restart_interval = std::stoi(std::string(arg.substr(std::string_view("--restart_interval=").size())));
+    } else if (arg.rfind("--index_shortening=", 0) == 0) {
+      cfg.index_shortening = ParseIndexShortening(arg.substr(std::string_view("--index_shortening=").size()));
+    } else if (arg.rfind("--compression_ratio=", 0) == 0) {
+      cfg.compression_ratio = std::stod(std::string(arg.substr(std::string_view("--compression_ratio=").size())));
+    } else if (arg == "--predict_only") {
+      cfg.predict_only = true;
+    } else if (arg == "--udt") {
+      cfg.udt = true;
+    } else if (arg.rfind("--insert_order=", 0) == 0) {
+      cfg.insert_order = ParseInsertOrder(arg.substr(std::string_view("--insert_order=").size()));
+    } else if (arg.rfind("--delete_fraction=", 0) == 0) {
+      cfg.delete_fraction = std::stod(std::string(arg.substr(std::string_view("--delete_fraction=").size())));
+    } else if (arg.rfind("--delete_kinds=", 0) == 0) {
+      cfg.delete_kinds = ParseDeleteKinds(arg.substr(std::string_view("--delete_kinds=").size()));
+    } else if (arg.rfind("--scan_threads=", 0) == 0) {
+      cfg.scan_threads = ParseThreadCounts(arg.substr(std::string_view("--scan_threads=").size()));
+    } else if (arg.rfind("--cache_allocator=", 0) == 0) {
+      cfg.cache_allocators = ParseCacheAllocators(arg.substr(std::string_view("--cache_allocator=").size()));
+    } else if (arg.rfind("--block_cache_bytes=", 0) == 0) {
+      std::string_view value = arg.substr(std::string_view("--block_cache_bytes=").size());
+      cfg.block_cache_bytes = std::stoull(std::string(value));
+    } else if (arg.rfind("--load_threads=", 0) == 0) {
+      std::string_view value = arg.substr(std::string_view("--load_threads=").size());
+      cfg.load_threads = std::max(1, std::stoi(std::string(value)));
     } else if (arg == "--help" || arg == "-h") {
-      std::cout << "Usage: space_amp [--block_sizes=csv] [--db_root=dir] [--keep_dbs] [--read_ops=N]\n";
+      std::cout << "Usage: space_amp [--block_sizes=csv] [--db_root=dir] [--keep_dbs] [--read_ops=N]"
+                   " [--buffered_reads] [--page_cache_residency] [--cache_trace]"
+                   " [--simulate_trace=file] [--cache_sizes=csv] [--warmup] [--warmup_cache_bytes=N]"
+                   " [--restart_interval=N] [--index_shortening=none|separators|all] [--udt]"
+                   " [--insert_order=sorted|random|reverse|interleaved] [--load_threads=N]"
+                   " [--delete_fraction=F] [--delete_kinds=point,single,range] [--scan_threads=csv]"
+                   " [--cache_allocator=default,thp,hugetlb] [--block_cache_bytes=N]\n"
+                   "       space_amp --predict_only [--key_size=N] [--value_size=N] [--dataset_bytes=N]"
+                   " [--compression_ratio=F] [--restart_interval=N] [--index_shortening=mode]\n"
+                   "       space_amp --advise [--memory_budget=bytes] [--key_size=N] [--value_size=N]"
+                   " [--dataset_bytes=N] [--scan_fraction=F] [--absent_fraction=F]"
+                   " [--device=nvme|ssd|hdd] [--target_ops=N] [--trial_entries=N] [--block_sizes=csv]\n";
       std::exit(EXIT_SUCCESS);
     } else {
       std::cerr << "Unknown argument: " << arg << "\n";
@@ -113,6 +454,9 @@ Config ParseArguments(int argc, char** argv) {
   if (cfg.block_sizes.empty()) {
     cfg.block_sizes = DefaultBlockSizes();
   }
+  if (cfg.cache_sizes.empty()) {
+    cfg.cache_sizes = DefaultCacheSizes();
+  }
   return cfg;
 }
 
@@ -127,7 +471,103 @@ void FillValue(uint64_t index, std::array<char, kValueSize>* buffer) {
   }
 }
 
-rocksdb::Options BuildOptions(int block_size) {
+// Stateless bijection over [0, n): a 4-round balanced Feistel network on the smallest even-width
+// power-of-two domain covering n, with cycle-walking to stay inside [0, n). Any position maps to
+// its key in O(1) without a shuffled array, so load threads can take disjoint position ranges.
+class FeistelPermutation {
+ public:
+  FeistelPermutation(uint64_t n, uint64_t seed) : n_(n), seed_(seed) {
+    int bits = 2;
+    while (bits < 64 && (1ull << bits) < n) {
+      bits += 2;
+    }
+    half_bits_ = bits / 2;
+    half_mask_ = (1ull << half_bits_) - 1;
+  }
+
+  uint64_t operator()(uint64_t x) const {
+    do {
+      x = Encrypt(x);
+    } while (x >= n_);
+    return x;
+  }
+
+ private:
+  static constexpr int kRounds = 4;
+
+  uint64_t Round(uint64_t half, int round) const {
+    uint64_t h = half ^ (seed_ + 0x9E3779B97F4A7C15ull * static_cast<uint64_t>(round + 1));
+    h ^= h >> 33;
+    h *= 0xFF51AFD7ED558CCDull;
+    h ^= h >> 33;
+    h *= 0xC4CEB9FE1A85EC53ull;
+    h ^= h >> 33;
+    return h & half_mask_;
+  }
+
+  uint64_t Encrypt(uint64_t x) const {
+    uint64_t left = x >> half_bits_;
+    uint64_t right = x & half_mask_;
+    for (int round = 0; round < kRounds; ++round) {
+      const uint64_t next_right = left ^ Round(right, round);
+      left = right;
+      right = next_right;
+    }
+    return (left << half_bits_) | right;
+  }
+
+  uint64_t n_;
+  uint64_t seed_;
+  int half_bits_ = 1;
+  uint64_t half_mask_ = 1;
+};
+
+// Interleaved ingest models several sorted producers writing concurrently: position p belongs to
+// stream p % kInterleaveStreams and is that stream's (p / kInterleaveStreams)-th key.
+constexpr uint64_t kInterleaveStreams = 16;
+static_assert(kEntryCount % kInterleaveStreams == 0, "streams must split the key space evenly");
+
+uint64_t KeyAtPosition(InsertOrder order, const FeistelPermutation& permutation, uint64_t position) {
+  switch (order) {
+    case InsertOrder::kSorted:
+      return position;
+    case InsertOrder::kRandom:
+      return permutation(position);
+    case InsertOrder::kReverse:
+      return kEntryCount - 1 - position;
+    case InsertOrder::kInterleaved:
+      return (position % kInterleaveStreams) * (kEntryCount / kInterleaveStreams) +
+             position / kInterleaveStreams;
+  }
+  return position;
+}
+
+// User-defined timestamps use BytewiseComparatorWithU64Ts, which expects fixed64 little-endian.
+constexpr size_t kTimestampSize = sizeof(uint64_t);
+constexpr uint64_t kLoadTimestamp = 1;
+
+std::array<char, kTimestampSize> EncodeTimestamp(uint64_t ts) {
+  std::array<char, kTimestampSize> out{};
+  for (size_t i = 0; i < kTimestampSize; ++i) {
+    out[i] = static_cast<char>((ts >> (8 * i)) & 0xff);
+  }
+  return out;
+}
+
+rocksdb::BlockBasedTableOptions BuildTableOptions(const Config& cfg, int block_size) {
+  rocksdb::BlockBasedTableOptions table_options;
+  table_options.block_size = block_size;
+  table_options.block_restart_interval = cfg.restart_interval;
+  table_options.index_shortening = cfg.index_shortening;
+  table_options.cache_index_and_filter_blocks = false;
+  table_options.pin_l0_filter_and_index_blocks_in_cache = false;
+  table_options.block_cache = nullptr;
+  table_options.no_block_cache = true;
+  table_options.filter_policy.reset();
+  return table_options;
+}
+
+rocksdb::Options BuildOptions(const Config& cfg, int block_size) {
   rocksdb::Options options;
   options.create_if_missing = true;
   options.error_if_exists = true;
@@ -143,25 +583,317 @@ rocksdb::Options BuildOptions(int block_size) {
   options.use_direct_reads = true;
   options.use_direct_io_for_flush_and_compaction = true;
   options.compaction_readahead_size = 2 * 1024 * 1024;
-  rocksdb::BlockBasedTableOptions table_options;
-  table_options.block_size = block_size;
-  table_options.cache_index_and_filter_blocks = false;
-  table_options.pin_l0_filter_and_index_blocks_in_cache = false;
-  table_options.block_cache = nullptr;
-  table_options.no_block_cache = true;
-  table_options.filter_policy.reset();
-
-  options.table_factory.reset(NewBlockBasedTableFactory(table_options));
+  options.table_factory.reset(NewBlockBasedTableFactory(BuildTableOptions(cfg, block_size)));
   return options;
 }
 
+// Byte range of one SST file. Data blocks are written back to back from offset 0, so the table's
+// data_size property is the offset of the first index/filter/meta block.
+struct SstRegion {
+  std::string path;
+  uint64_t file_size = 0;
+  uint64_t data_end = 0;
+};
+
+std::vector<SstRegion> CollectSstRegions(rocksdb::DB* db) {
+  rocksdb::TablePropertiesCollection properties;
+  auto status = db->GetPropertiesOfAllTables(&properties);
+  if (!status.ok()) {
+    throw std::runtime_error("Failed to get table properties: " + status.ToString());
+  }
+  std::vector<SstRegion> regions;
+  regions.reserve(properties.size());
+  for (const auto& [path, props] : properties) {
+    SstRegion region;
+    region.path = path;
+    region.file_size = std::filesystem::file_size(path);
+    region.data_end = std::min(props->data_size, region.file_size);
+    regions.push_back(std::move(region));
+  }
+  return regions;
+}
+
+// Drops every SST file under db_path from the page cache. Runs before the DB is opened, so the
+// footer, index and filter reads issued by the table readers show up in the baseline probe.
+void EvictSstFiles(const std::filesystem::path& db_path) {
+  for (const auto& entry : std::filesystem::directory_iterator(db_path)) {
+    if (!entry.is_regular_file() || entry.path().extension() != ".sst") {
+      continue;
+    }
+    const std::string path = entry.path().string();
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+      throw std::runtime_error("Failed to open " + path + ": " + std::strerror(errno));
+    }
+#ifdef POSIX_FADV_DONTNEED
+    ::posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+#endif
+    ::close(fd);
+  }
+}
+
+ResidencyStats ProbeResidency(const std::vector<SstRegion>& regions) {
+#if defined(__APPLE__)
+  using MincoreVec = char;
+#else
+  using MincoreVec = unsigned char;
+#endif
+  const uint64_t page_size = static_cast<uint64_t>(::sysconf(_SC_PAGESIZE));
+  ResidencyStats stats;
+  std::vector<MincoreVec> pages;
+  for (const auto& region : regions) {
+    stats.data_bytes += region.data_end;
+    stats.meta_bytes += region.file_size - region.data_end;
+    if (region.file_size == 0) {
+      continue;
+    }
+    int fd = ::open(region.path.c_str(), O_RDONLY);
+    if (fd < 0) {
+      throw std::runtime_error("Failed to open " + region.path + ": " + std::strerror(errno));
+    }
+    void* addr = ::mmap(nullptr, region.file_size, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (addr == MAP_FAILED) {
+      throw std::runtime_error("Failed to mmap " + region.path + ": " + std::strerror(errno));
+    }
+    pages.assign((region.file_size + page_size - 1) / page_size, 0);
+    int rc = ::mincore(addr, region.file_size, pages.data());
+    int mincore_errno = errno;
+    ::munmap(addr, region.file_size);
+    if (rc != 0) {
+      throw std::runtime_error("mincore failed for " + region.path + ": " +
+                               std::strerror(mincore_errno));
+    }
+    for (size_t p = 0; p < pages.size(); ++p) {
+      if ((pages[p] & 1) == 0) {
+        continue;
+      }
+      const uint64_t begin = p * page_size;
+      const uint64_t end = std::min(begin + page_size, region.file_size);
+      const uint64_t data_part = begin < region.data_end ? std::min(end, region.data_end) - begin : 0;
+      stats.data_resident_bytes += data_part;
+      stats.meta_resident_bytes += (end - begin) - data_part;
+    }
+  }
+  return stats;
+}
+
+// Block cache traces are stored in a compact format of our own: a header followed by one
+// fixed-size record per block lookup. Only the cache key hash, the block size and the block type
+// are kept, which is all the simulator needs.
+constexpr char kCacheTraceMagic[8] = {'S', 'A', 'C', 'T', 'R', 'C', '0', '1'};
+
+struct CacheTraceRecord {
+  uint64_t key_hash = 0;
+  uint32_t block_bytes = 0;
+  uint8_t block_type = 0;
+};
+
+class CompactBlockCacheTraceWriter : public rocksdb::BlockCacheTraceWriter {
+ public:
+  CompactBlockCacheTraceWriter(const std::filesystem::path& path, int block_size)
+      : out_(path, std::ios::binary | std::ios::trunc), block_size_(static_cast<uint32_t>(block_size)) {
+    if (!out_) {
+      throw std::runtime_error("Failed to create cache trace " + path.string());
+    }
+  }
+
+  rocksdb::Status WriteHeader() override {
+    out_.write(kCacheTraceMagic, sizeof(kCacheTraceMagic));
+    out_.write(reinterpret_cast<const char*>(&block_size_), sizeof(block_size_));
+    return out_ ? rocksdb::Status::OK() : rocksdb::Status::IOError("cache trace header write failed");
+  }
+
+  rocksdb::Status WriteBlockAccess(const rocksdb::BlockCacheTraceRecord& record,
+                                   const rocksdb::Slice& block_key, const rocksdb::Slice& cf_name,
+                                   const rocksdb::Slice& referenced_key) override {
+    (void)cf_name;
+    (void)referenced_key;
+    const uint64_t key_hash = std::hash<std::string_view>{}(std::string_view(block_key.data(), block_key.size()));
+    const uint32_t block_bytes = static_cast<uint32_t>(record.block_size);
+    const uint8_t block_type = static_cast<uint8_t>(record.block_type);
+    out_.write(reinterpret_cast<const char*>(&key_hash), sizeof(key_hash));
+    out_.write(reinterpret_cast<const char*>(&block_bytes), sizeof(block_bytes));
+    out_.write(reinterpret_cast<const char*>(&block_type), sizeof(block_type));
+    return out_ ? rocksdb::Status::OK() : rocksdb::Status::IOError("cache trace record write failed");
+  }
+
+ private:
+  std::ofstream out_;
+  uint32_t block_size_;
+};
+
+std::vector<CacheTraceRecord> LoadCacheTrace(const std::filesystem::path& path, int* block_size) {
+  std::ifstream in(path, std::ios::binary);
+  if (!in) {
+    throw std::runtime_error("Failed to open cache trace " + path.string());
+  }
+  char magic[sizeof(kCacheTraceMagic)] = {};
+  uint32_t traced_block_size = 0;
+  in.read(magic, sizeof(magic));
+  in.read(reinterpret_cast<char*>(&traced_block_size), sizeof(traced_block_size));
+  if (!in || std::memcmp(magic, kCacheTraceMagic, sizeof(magic)) != 0) {
+    throw std::runtime_error("Not a space_amp cache trace: " + path.string());
+  }
+  *block_size = static_cast<int>(traced_block_size);
+  std::vector<CacheTraceRecord> records;
+  CacheTraceRecord record;
+  while (in.read(reinterpret_cast<char*>(&record.key_hash), sizeof(record.key_hash)) &&
+         in.read(reinterpret_cast<char*>(&record.block_bytes), sizeof(record.block_bytes)) &&
+         in.read(reinterpret_cast<char*>(&record.block_type), sizeof(record.block_type))) {
+    records.push_back(record);
+  }
+  return records;
+}
+
+struct MissRatioPoint {
+  uint64_t capacity = 0;
+  double lru_miss_ratio = 0.0;
+  double clock_miss_ratio = 0.0;
+};
+
+// Byte-capacity CLOCK (second chance): a hit sets the reference bit; eviction walks the ring from
+// the oldest entry, clearing reference bits until it finds an unreferenced victim.
+class ClockCacheSim {
+ public:
+  explicit ClockCacheSim(uint64_t capacity) : capacity_(capacity) {}
+
+  bool Access(uint64_t key, uint64_t bytes) {
+    auto it = entries_.find(key);
+    if (it != entries_.end()) {
+      it->second.referenced = true;
+      return true;
+    }
+    if (bytes > capacity_) {
+      return false;
+    }
+    while (usage_ + bytes > capacity_) {
+      const uint64_t victim = ring_.front();
+      ring_.pop_front();
+      auto victim_it = entries_.find(victim);
+      if (victim_it->second.referenced) {
+        victim_it->second.referenced = false;
+        ring_.push_back(victim);
+      } else {
+        usage_ -= victim_it->second.bytes;
+        entries_.erase(victim_it);
+      }
+    }
+    entries_.emplace(key, Entry{bytes, false});
+    ring_.push_back(key);
+    usage_ += bytes;
+    return false;
+  }
+
+ private:
+  struct Entry {
+    uint64_t bytes;
+    bool referenced;
+  };
+  uint64_t capacity_;
+  uint64_t usage_ = 0;
+  std::unordered_map<uint64_t, Entry> entries_;
+  std::deque<uint64_t> ring_;
+};
+
+// Replays a trace against every capacity in a single pass. LRU uses Mattson's stack algorithm: a
+// Fenwick tree over access positions yields each access's byte stack distance (the bytes of the
+// distinct blocks touched since the previous access to the same block), and the access hits in any
+// LRU cache at least that large. CLOCK has no inclusion property, so one simulator per capacity is
+// fed from the same pass.
+std::vector<MissRatioPoint> SimulateMissRatios(const std::vector<CacheTraceRecord>& records,
+                                               const std::vector<uint64_t>& capacities) {
+  std::vector<MissRatioPoint> points(capacities.size());
+  if (records.empty()) {
+    return points;
+  }
+  std::vector<int64_t> fenwick(records.size() + 1, 0);
+  auto add = [&](size_t pos, int64_t delta) {
+    for (size_t i = pos + 1; i < fenwick.size(); i += i & (~i + 1)) {
+      fenwick[i] += delta;
+    }
+  };
+  auto prefix = [&](size_t pos) {  // Sum over positions [0, pos).
+    int64_t sum = 0;
+    for (size_t i = pos; i > 0; i -= i & (~i + 1)) {
+      sum += fenwick[i];
+    }
+    return sum;
+  };
+
+  std::unordered_map<uint64_t, size_t> last_access;
+  std::vector<ClockCacheSim> clocks;
+  clocks.reserve(capacities.size());
+  for (uint64_t capacity : capacities) {
+    clocks.emplace_back(capacity);
+  }
+  std::vector<uint64_t> lru_misses(capacities.size(), 0);
+  std::vector<uint64_t> clock_misses(capacities.size(), 0);
+
+  for (size_t i = 0; i < records.size(); ++i) {
+    const CacheTraceRecord& record = records[i];
+    const uint64_t bytes = record.block_bytes;
+    auto it = last_access.find(record.key_hash);
+    bool cold = it == last_access.end();
+    uint64_t distance = 0;
+    if (!cold) {
+      distance = static_cast<uint64_t>(prefix(i) - prefix(it->second + 1)) + bytes;
+      add(it->second, -static_cast<int64_t>(bytes));
+      it->second = i;
+    } else {
+      last_access.emplace(record.key_hash, i);
+    }
+    add(i, static_cast<int64_t>(bytes));
+    for (size_t c = 0; c < capacities.size(); ++c) {
+      if (cold || distance > capacities[c]) {
+        ++lru_misses[c];
+      }
+      if (!clocks[c].Access(record.key_hash, bytes)) {
+        ++clock_misses[c];
+      }
+    }
+  }
+
+  const double total = static_cast<double>(records.size());
+  for (size_t c = 0; c < capacities.size(); ++c) {
+    points[c].capacity = capacities[c];
+    points[c].lru_miss_ratio = static_cast<double>(lru_misses[c]) / total;
+    points[c].clock_miss_ratio = static_cast<double>(clock_misses[c]) / total;
+  }
+  return points;
+}
+
+void PrintMissRatioCurve(int block_size, size_t accesses, const std::vector<MissRatioPoint>& points) {
+  std::cout << "\nSimulated block cache miss ratio (block=" << HumanBytes(block_size) << ", " << accesses
+            << " block accesses)\n";
+  std::cout << std::left << std::setw(12) << "Capacity"
+            << std::right << std::setw(12) << "LRU miss%"
+            << std::setw(14) << "CLOCK miss%" << "\n";
+  for (const auto& point : points) {
+    std::cout << std::left << std::setw(12) << HumanBytes(static_cast<double>(point.capacity))
+              << std::right << std::setw(12) << std::fixed << std::setprecision(2)
+              << 100.0 * point.lru_miss_ratio
+              << std::setw(14) << 100.0 * point.clock_miss_ratio << "\n";
+  }
+}
+
+void SimulateTraceFile(const std::filesystem::path& path, const std::vector<uint64_t>& capacities) {
+  int block_size = 0;
+  std::vector<CacheTraceRecord> records = LoadCacheTrace(path, &block_size);
+  PrintMissRatioCurve(block_size, records.size(), SimulateMissRatios(records, capacities));
+}
+
 struct ReadStats {
   double ops_per_sec = 0.0;
+  ResidencyStats residency_before;
+  ResidencyStats residency_after;
+  std::filesystem::path cache_trace_path;
 };
 
 ReadStats BenchmarkReads(const std::filesystem::path& db_path, const rocksdb::Options& template_options,
-                         uint64_t read_ops) {
+                         const Config& cfg, int block_size) {
   ReadStats stats;
+  const uint64_t read_ops = cfg.read_ops;
   if (read_ops == 0) {
     return stats;
   }
@@ -169,6 +901,20 @@ ReadStats BenchmarkReads(const std::filesystem::path& db_path, const rocksdb::Op
   rocksdb::Options options = template_options;
   options.create_if_missing = false;
   options.error_if_exists = false;
+  if (cfg.buffered_reads) {
+    options.use_direct_reads = false;
+  }
+  if (cfg.cache_trace) {
+    // Block cache tracing hooks block cache lookups, so a cache must exist. fill_cache stays off,
+    // so the traced access stream is the same as the uncached benchmark's.
+    rocksdb::BlockBasedTableOptions table_options = BuildTableOptions(cfg, block_size);
+    table_options.no_block_cache = false;
+    table_options.block_cache = rocksdb::NewLRUCache(8ull * 1024ull * 1024ull);
+    options.table_factory.reset(NewBlockBasedTableFactory(table_options));
+  }
+  if (cfg.page_cache_residency) {
+    EvictSstFiles(db_path);
+  }
   rocksdb::DB* raw_db = nullptr;
   auto status = rocksdb::DB::OpenForReadOnly(options, db_path.string(), &raw_db);
   if (!status.ok()) {
@@ -177,15 +923,36 @@ ReadStats BenchmarkReads(const std::filesystem::path& db_path, const rocksdb::Op
   }
   std::unique_ptr<rocksdb::DB> db(raw_db);
 
+  std::vector<SstRegion> regions;
+  if (cfg.page_cache_residency) {
+    regions = CollectSstRegions(db.get());
+    stats.residency_before = ProbeResidency(regions);
+  }
+
   rocksdb::ReadOptions read_options;
   read_options.fill_cache = false;
   read_options.verify_checksums = false;
+  const auto read_ts = EncodeTimestamp(std::numeric_limits<uint64_t>::max());
+  const rocksdb::Slice read_ts_slice(read_ts.data(), read_ts.size());
+  if (options.comparator->timestamp_size() > 0) {
+    read_options.timestamp = &read_ts_slice;
+  }
 
   std::mt19937_64 rng(0xC0FFEE);
   std::uniform_int_distribution<uint64_t> dist(0, kEntryCount - 1);
   std::array<char, kKeySize + 1> key_buffer{};
   rocksdb::PinnableSlice value;
 
+  if (cfg.cache_trace) {
+    stats.cache_trace_path = cfg.db_root / ("block_" + std::to_string(block_size) + ".cache_trace");
+    status = db->StartBlockCacheTrace(rocksdb::BlockCacheTraceOptions(),
+                                      std::make_unique<CompactBlockCacheTraceWriter>(
+                                          stats.cache_trace_path, block_size));
+    if (!status.ok()) {
+      throw std::runtime_error("StartBlockCacheTrace failed: " + status.ToString());
+    }
+  }
+
   auto start = std::chrono::steady_clock::now();
   for (uint64_t i = 0; i < read_ops; ++i) {
     uint64_t key_index = dist(rng);
@@ -198,69 +965,1038 @@ ReadStats BenchmarkReads(const std::filesystem::path& db_path, const rocksdb::Op
     value.Reset();
   }
   auto end = std::chrono::steady_clock::now();
+  if (cfg.cache_trace) {
+    status = db->EndBlockCacheTrace();
+    if (!status.ok()) {
+      throw std::runtime_error("EndBlockCacheTrace failed: " + status.ToString());
+    }
+  }
   double seconds = std::chrono::duration<double>(end - start).count();
   if (seconds <= 0.0) {
     seconds = 1e-9;
   }
   stats.ops_per_sec = static_cast<double>(read_ops) / seconds;
+  if (cfg.page_cache_residency) {
+    stats.residency_after = ProbeResidency(regions);
+  }
   return stats;
 }
 
-Result RunOnce(const Config& cfg, int block_size) {
-  Result result;
-  result.block_size = block_size;
-  const std::filesystem::path db_path = cfg.db_root / ("block_" + std::to_string(block_size));
-  std::filesystem::create_directories(cfg.db_root);
-  if (std::filesystem::exists(db_path)) {
-    std::filesystem::remove_all(db_path);
+// The warm-up workload is skewed: kHotAccessProb of the lookups go to a hot set of
+// kHotKeyFraction of the keys, spread evenly over the key space so that hot keys rarely share a
+// block. A cache that holds exactly the hot blocks therefore costs hot_keys * block_size.
+constexpr double kHotKeyFraction = 0.001;
+constexpr double kHotAccessProb = 0.9;
+constexpr uint64_t kHotKeyCount = static_cast<uint64_t>(kEntryCount * kHotKeyFraction);
+constexpr uint64_t kHotKeyStride = kEntryCount / kHotKeyCount;
+constexpr int kWarmupWindows = 50;
+constexpr double kSteadyHitRatioSlack = 0.02;
+
+enum class WarmupStrategy { kNone, kFullScan, kHotKeyReplay, kPrepopulateOnFlush };
+
+const char* WarmupStrategyName(WarmupStrategy strategy) {
+  switch (strategy) {
+    case WarmupStrategy::kNone:
+      return "none";
+    case WarmupStrategy::kFullScan:
+      return "full_scan";
+    case WarmupStrategy::kHotKeyReplay:
+      return "hot_keys";
+    case WarmupStrategy::kPrepopulateOnFlush:
+      return "prepopulate";
   }
+  return "unknown";
+}
 
-  rocksdb::Options options = BuildOptions(block_size);
-  rocksdb::DB* raw_db = nullptr;
-  auto status = rocksdb::DB::Open(options, db_path.string(), &raw_db);
-  if (!status.ok()) {
-    throw std::runtime_error("Failed to open RocksDB at " + db_path.string() + ": " + status.ToString());
+uint64_t PickSkewedKey(std::mt19937_64* rng) {
+  std::uniform_real_distribution<double> coin(0.0, 1.0);
+  if (coin(*rng) < kHotAccessProb) {
+    std::uniform_int_distribution<uint64_t> hot(0, kHotKeyCount - 1);
+    return hot(*rng) * kHotKeyStride;
   }
-  std::unique_ptr<rocksdb::DB> db(raw_db);
+  std::uniform_int_distribution<uint64_t> any(0, kEntryCount - 1);
+  return any(*rng);
+}
 
-  rocksdb::WriteOptions write_options;
-  write_options.disableWAL = true;
-  rocksdb::WriteBatch batch;
-  const size_t batch_size = 1'000;
-  std::array<char, kKeySize + 1> key_buffer{};
-  std::array<char, kValueSize> value_buffer{};
+// Stands in for the access log a node would persist before restarting: sample the workload,
+// rank keys by frequency and keep the kHotKeyCount hottest.
+void SaveHotKeyList(const std::filesystem::path& path, uint64_t samples) {
+  std::mt19937_64 rng(0xFEEDBEEF);
+  std::unordered_map<uint64_t, uint32_t> counts;
+  for (uint64_t i = 0; i < samples; ++i) {
+    ++counts[PickSkewedKey(&rng)];
+  }
+  std::vector<std::pair<uint64_t, uint32_t>> ranked(counts.begin(), counts.end());
+  std::sort(ranked.begin(), ranked.end(),
+            [](const auto& a, const auto& b) { return a.second != b.second ? a.second > b.second : a.first < b.first; });
+  if (ranked.size() > kHotKeyCount) {
+    ranked.resize(kHotKeyCount);
+  }
+  std::ofstream out(path, std::ios::trunc);
+  if (!out) {
+    throw std::runtime_error("Failed to create hot key list " + path.string());
+  }
+  for (const auto& [key_index, count] : ranked) {
+    out << key_index << "\n";
+  }
+}
 
-  for (uint64_t i = 0; i < kEntryCount; ++i) {
-    FormatKey(i, &key_buffer);
-    FillValue(i, &value_buffer);
-    rocksdb::Slice key_slice(key_buffer.data(), kKeySize);
-    rocksdb::Slice value_slice(value_buffer.data(), kValueSize);
-    batch.Put(key_slice, value_slice);
-    if (batch.Count() >= static_cast<int>(batch_size)) {
-      status = db->Write(write_options, &batch);
-      if (!status.ok()) {
-        throw std::runtime_error("Write failed: " + status.ToString());
+std::vector<uint64_t> LoadHotKeyList(const std::filesystem::path& path) {
+  std::ifstream in(path);
+  if (!in) {
+    throw std::runtime_error("Failed to open hot key list " + path.string());
+  }
+  std::vector<uint64_t> keys;
+  uint64_t key_index = 0;
+  while (in >> key_index) {
+    keys.push_back(key_index);
+  }
+  std::sort(keys.begin(), keys.end());
+  return keys;
+}
+
+void WarmUp(rocksdb::DB* db, WarmupStrategy strategy, const std::filesystem::path& hot_key_path) {
+  std::array<char, kKeySize + 1> key_buffer{};
+  rocksdb::ReadOptions read_options;
+  read_options.verify_checksums = false;
+  switch (strategy) {
+    case WarmupStrategy::kNone:
+      return;
+    case WarmupStrategy::kFullScan: {
+      read_options.readahead_size = 2 * 1024 * 1024;
+      std::unique_ptr<rocksdb::Iterator> it(db->NewIterator(read_options));
+      for (it->SeekToFirst(); it->Valid(); it->Next()) {
       }
-      batch.Clear();
+      if (!it->status().ok()) {
+        throw std::runtime_error("Warm-up scan failed: " + it->status().ToString());
+      }
+      return;
     }
-  }
-  if (batch.Count() > 0) {
-    status = db->Write(write_options, &batch);
-    if (!status.ok()) {
-      throw std::runtime_error("Write failed: " + status.ToString());
+    case WarmupStrategy::kHotKeyReplay: {
+      rocksdb::PinnableSlice value;
+      for (uint64_t key_index : LoadHotKeyList(hot_key_path)) {
+        FormatKey(key_index, &key_buffer);
+        auto status = db->Get(read_options, db->DefaultColumnFamily(),
+                              rocksdb::Slice(key_buffer.data(), kKeySize), &value);
+        if (!status.ok()) {
+          throw std::runtime_error("Warm-up read failed: " + status.ToString());
+        }
+        value.Reset();
+      }
+      return;
+    }
+    case WarmupStrategy::kPrepopulateOnFlush: {
+      // prepopulate_block_cache only warms blocks written by a flush, so rewrite the hot keys
+      // (same values) and flush them; the new L0 file lands in the cache as it is written.
+      rocksdb::WriteOptions write_options;
+      write_options.disableWAL = true;
+      std::array<char, kValueSize> value_buffer{};
+      rocksdb::WriteBatch batch;
+      for (uint64_t key_index : LoadHotKeyList(hot_key_path)) {
+        FormatKey(key_index, &key_buffer);
+        FillValue(key_index, &value_buffer);
+        batch.Put(rocksdb::Slice(key_buffer.data(), kKeySize),
+                  rocksdb::Slice(value_buffer.data(), kValueSize));
+      }
+      auto status = db->Write(write_options, &batch);
+      if (!status.ok()) {
+        throw std::runtime_error("Warm-up write failed: " + status.ToString());
+      }
+      rocksdb::FlushOptions flush_options;
+      flush_options.wait = true;
+      status = db->Flush(flush_options);
+      if (!status.ok()) {
+        throw std::runtime_error("Warm-up flush failed: " + status.ToString());
+      }
+      return;
     }
-    batch.Clear();
   }
+}
 
-  rocksdb::FlushOptions flush_options;
-  flush_options.wait = true;
-  status = db->Flush(flush_options);
-  if (!status.ok()) {
-    throw std::runtime_error("Flush failed: " + status.ToString());
+// Replaces copy_path with a checkpoint of the DB at db_path, so phases that write can run without
+// changing the base DB the later phases read.
+void CreateCheckpointCopy(const rocksdb::Options& options, const std::filesystem::path& db_path,
+                          const std::filesystem::path& copy_path) {
+  if (std::filesystem::exists(copy_path)) {
+    std::filesystem::remove_all(copy_path);
   }
-  status = db->CompactRange(rocksdb::CompactRangeOptions(), nullptr, nullptr);
+  rocksdb::DB* raw_base = nullptr;
+  auto status = rocksdb::DB::Open(options, db_path.string(), &raw_base);
   if (!status.ok()) {
-    throw std::runtime_error("CompactRange failed: " + status.ToString());
+    throw std::runtime_error("Failed to reopen RocksDB at " + db_path.string() + ": " + status.ToString());
+  }
+  std::unique_ptr<rocksdb::DB> base(raw_base);
+  rocksdb::Checkpoint* raw_checkpoint = nullptr;
+  status = rocksdb::Checkpoint::Create(base.get(), &raw_checkpoint);
+  std::unique_ptr<rocksdb::Checkpoint> checkpoint(raw_checkpoint);
+  if (status.ok()) {
+    status = checkpoint->CreateCheckpoint(copy_path.string());
+  }
+  if (!status.ok()) {
+    throw std::runtime_error("Checkpoint failed: " + status.ToString());
+  }
+}
+
+WarmupStats MeasureWarmup(const std::filesystem::path& db_path, const rocksdb::Options& template_options,
+                          const Config& cfg, int block_size, WarmupStrategy strategy,
+                          const std::filesystem::path& hot_key_path) {
+  WarmupStats stats;
+  stats.strategy = WarmupStrategyName(strategy);
+
+  rocksdb::Options options = template_options;
+  options.create_if_missing = false;
+  options.error_if_exists = false;
+  options.disable_auto_compactions = true;
+  options.statistics = rocksdb::CreateDBStatistics();
+  rocksdb::BlockBasedTableOptions table_options = BuildTableOptions(cfg, block_size);
+  table_options.no_block_cache = false;
+  table_options.block_cache = rocksdb::NewLRUCache(cfg.warmup_cache_bytes);
+  if (strategy == WarmupStrategy::kPrepopulateOnFlush) {
+    table_options.prepopulate_block_cache =
+        rocksdb::BlockBasedTableOptions::PrepopulateBlockCache::kFlushOnly;
+  }
+  options.table_factory.reset(NewBlockBasedTableFactory(table_options));
+
+  // Only prepopulate writes, and it runs on its own checkpoint copy. The other strategies open the
+  // shared base read-only, so none of them can flush, compact or rewrite the MANIFEST under the next.
+  rocksdb::DB* raw_db = nullptr;
+  auto status = strategy == WarmupStrategy::kPrepopulateOnFlush
+                    ? rocksdb::DB::Open(options, db_path.string(), &raw_db)
+                    : rocksdb::DB::OpenForReadOnly(options, db_path.string(), &raw_db);
+  if (!status.ok()) {
+    throw std::runtime_error("Failed to reopen RocksDB for warm-up at " + db_path.string() + ": " +
+                             status.ToString());
+  }
+  std::unique_ptr<rocksdb::DB> db(raw_db);
+  rocksdb::Statistics* statistics = options.statistics.get();
+
+  auto restart = std::chrono::steady_clock::now();
+  rocksdb::get_iostats_context()->Reset();
+  WarmUp(db.get(), strategy, hot_key_path);
+  auto warm = std::chrono::steady_clock::now();
+  stats.warmup_seconds = std::chrono::duration<double>(warm - restart).count();
+  stats.warmup_bytes_read = rocksdb::get_iostats_context()->bytes_read;
+  stats.cache_bytes_after_warmup = table_options.block_cache->GetUsage();
+
+  // Serve the skewed workload in windows and record each window's data-block hit ratio.
+  const uint64_t window_ops = std::max<uint64_t>(1, cfg.read_ops / kWarmupWindows);
+  rocksdb::ReadOptions read_options;
+  read_options.verify_checksums = false;
+  std::mt19937_64 rng(0xC0FFEE);
+  std::array<char, kKeySize + 1> key_buffer{};
+  rocksdb::PinnableSlice value;
+  std::vector<double> hit_ratios;
+  std::vector<double> window_end_seconds;
+  std::vector<double> window_ops_per_sec;
+  uint64_t prev_hits = statistics->getTickerCount(rocksdb::BLOCK_CACHE_DATA_HIT);
+  uint64_t prev_misses = statistics->getTickerCount(rocksdb::BLOCK_CACHE_DATA_MISS);
+  for (uint64_t done = 0; done < cfg.read_ops;) {
+    const uint64_t ops = std::min(window_ops, cfg.read_ops - done);
+    auto window_start = std::chrono::steady_clock::now();
+    for (uint64_t i = 0; i < ops; ++i) {
+      FormatKey(PickSkewedKey(&rng), &key_buffer);
+      status = db->Get(read_options, db->DefaultColumnFamily(),
+                       rocksdb::Slice(key_buffer.data(), kKeySize), &value);
+      if (!status.ok()) {
+        throw std::runtime_error("Read failed: " + status.ToString());
+      }
+      value.Reset();
+    }
+    auto window_end = std::chrono::steady_clock::now();
+    done += ops;
+    const uint64_t hits = statistics->getTickerCount(rocksdb::BLOCK_CACHE_DATA_HIT);
+    const uint64_t misses = statistics->getTickerCount(rocksdb::BLOCK_CACHE_DATA_MISS);
+    const uint64_t lookups = (hits - prev_hits) + (misses - prev_misses);
+    hit_ratios.push_back(lookups == 0 ? 0.0 : static_cast<double>(hits - prev_hits) / lookups);
+    prev_hits = hits;
+    prev_misses = misses;
+    window_end_seconds.push_back(std::chrono::duration<double>(window_end - restart).count());
+    window_ops_per_sec.push_back(static_cast<double>(ops) /
+                                 std::max(1e-9, std::chrono::duration<double>(window_end - window_start).count()));
+  }
+  if (hit_ratios.empty()) {
+    return stats;
+  }
+
+  // Steady state is the average over the last quarter of the windows; recovery completes at the
+  // first window within kSteadyHitRatioSlack of it.
+  const size_t tail_begin = hit_ratios.size() - std::max<size_t>(1, hit_ratios.size() / 4);
+  for (size_t w = tail_begin; w < hit_ratios.size(); ++w) {
+    stats.steady_hit_ratio += hit_ratios[w];
+    stats.steady_ops_per_sec += window_ops_per_sec[w];
+  }
+  stats.steady_hit_ratio /= static_cast<double>(hit_ratios.size() - tail_begin);
+  stats.steady_ops_per_sec /= static_cast<double>(hit_ratios.size() - tail_begin);
+  stats.first_window_hit_ratio = hit_ratios.front();
+  stats.seconds_to_steady = window_end_seconds.back();
+  for (size_t w = 0; w < hit_ratios.size(); ++w) {
+    if (hit_ratios[w] >= stats.steady_hit_ratio - kSteadyHitRatioSlack) {
+      stats.seconds_to_steady = window_end_seconds[w];
+      break;
+    }
+  }
+  return stats;
+}
+
+// Each strategy reopens the DB with an empty block cache, read-only. Prepopulate rewrites the hot keys
+// into a new L0 file, so it runs read-write on a checkpoint copy that is deleted afterwards.
+std::vector<WarmupStats> BenchmarkWarmup(const std::filesystem::path& db_path, const rocksdb::Options& options,
+                                         const Config& cfg, int block_size) {
+  const std::filesystem::path hot_key_path = cfg.db_root / ("block_" + std::to_string(block_size) + ".hot_keys");
+  SaveHotKeyList(hot_key_path, 10 * kHotKeyCount);
+  std::vector<WarmupStats> stats;
+  for (WarmupStrategy strategy : {WarmupStrategy::kNone, WarmupStrategy::kFullScan,
+                                  WarmupStrategy::kHotKeyReplay, WarmupStrategy::kPrepopulateOnFlush}) {
+    std::cout << "[block=" << block_size << "] warm-up strategy " << WarmupStrategyName(strategy) << "...\n";
+    if (strategy != WarmupStrategy::kPrepopulateOnFlush) {
+      stats.push_back(MeasureWarmup(db_path, options, cfg, block_size, strategy, hot_key_path));
+      continue;
+    }
+    rocksdb::Options copy_options = options;
+    copy_options.create_if_missing = false;
+    copy_options.error_if_exists = false;
+    copy_options.disable_auto_compactions = true;
+    const std::filesystem::path copy_path = cfg.db_root / ("block_" + std::to_string(block_size) + "_warmup");
+    CreateCheckpointCopy(copy_options, db_path, copy_path);
+    stats.push_back(MeasureWarmup(copy_path, options, cfg, block_size, strategy, hot_key_path));
+    std::filesystem::remove_all(copy_path);
+  }
+  std::filesystem::remove(hot_key_path);
+  return stats;
+}
+
+constexpr size_t kScanReadaheadBytes = 2 * 1024 * 1024;
+
+// Splits the key space into `threads` equal ranges, each scanned by its own iterator bounded by
+// iterate_lower_bound/iterate_upper_bound, and checks that the ranges add up to every row.
+ScanStats ParallelScan(rocksdb::DB* db, int threads) {
+  ScanStats stats;
+  stats.threads = threads;
+  std::vector<uint64_t> rows(threads, 0);
+  std::vector<uint64_t> bytes(threads, 0);
+  std::vector<std::thread> workers;
+  std::vector<std::exception_ptr> errors(threads);
+  auto start = std::chrono::steady_clock::now();
+  for (int t = 0; t < threads; ++t) {
+    workers.emplace_back([&, t]() {
+      try {
+        const uint64_t begin = kEntryCount * t / threads;
+        const uint64_t end = kEntryCount * (t + 1) / threads;
+        std::array<char, kKeySize + 1> lower_buffer{};
+        std::array<char, kKeySize + 1> upper_buffer{};
+        FormatKey(begin, &lower_buffer);
+        FormatKey(end, &upper_buffer);
+        rocksdb::Slice lower(lower_buffer.data(), kKeySize);
+        rocksdb::Slice upper(upper_buffer.data(), kKeySize);
+        rocksdb::ReadOptions read_options;
+        read_options.fill_cache = false;
+        read_options.verify_checksums = false;
+        read_options.readahead_size = kScanReadaheadBytes;
+        read_options.iterate_lower_bound = &lower;
+        read_options.iterate_upper_bound = t + 1 == threads ? nullptr : &upper;
+        std::unique_ptr<rocksdb::Iterator> it(db->NewIterator(read_options));
+        for (it->Seek(lower); it->Valid(); it->Next()) {
+          ++rows[t];
+          bytes[t] += it->key().size() + it->value().size();
+        }
+        if (!it->status().ok()) {
+          throw std::runtime_error("Scan failed: " + it->status().ToString());
+        }
+      } catch (...) {
+        errors[t] = std::current_exception();
+      }
+    });
+  }
+  for (auto& worker : workers) {
+    worker.join();
+  }
+  for (const auto& error : errors) {
+    if (error) {
+      std::rethrow_exception(error);
+    }
+  }
+  stats.seconds = std::max(1e-9, std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+  for (int t = 0; t < threads; ++t) {
+    stats.rows += rows[t];
+    stats.bytes += bytes[t];
+  }
+  if (stats.rows != kEntryCount) {
+    throw std::runtime_error("Full scan with " + std::to_string(threads) + " threads returned " +
+                             std::to_string(stats.rows) + " rows, expected " + std::to_string(kEntryCount));
+  }
+  return stats;
+}
+
+std::vector<ScanStats> BenchmarkParallelScans(const std::filesystem::path& db_path,
+                                              const rocksdb::Options& template_options, const Config& cfg,
+                                              int block_size) {
+  rocksdb::Options options = template_options;
+  options.create_if_missing = false;
+  options.error_if_exists = false;
+  rocksdb::DB* raw_db = nullptr;
+  auto status = rocksdb::DB::OpenForReadOnly(options, db_path.string(), &raw_db);
+  if (!status.ok()) {
+    throw std::runtime_error("Failed to reopen RocksDB for scans at " + db_path.string() + ": " +
+                             status.ToString());
+  }
+  std::unique_ptr<rocksdb::DB> db(raw_db);
+  std::vector<ScanStats> stats;
+  for (int threads : cfg.scan_threads) {
+    std::cout << "[block=" << block_size << "] full scan with " << threads << " thread"
+              << (threads == 1 ? "" : "s") << "...\n";
+    stats.push_back(ParallelScan(db.get(), threads));
+  }
+  return stats;
+}
+
+// ---------------------------------------------------------------------------------------------
+// Hugepage-backed block cache.
+//
+// The arena carves block cache allocations out of large chunks that are either madvise'd for
+// transparent huge pages or mapped from the hugetlbfs pool, so a multi-GB cache is covered by a
+// few thousand TLB entries instead of a million. Sizes are rounded up to size classes, and freed
+// blocks go on a free list per class, so a block can be reused for any request in its class.
+// Requests larger than a chunk, or made after mmap fails, are served from malloc instead: throwing
+// from inside a block cache insert would take the process down.
+
+constexpr size_t kHugePageBytes = 2 * 1024 * 1024;
+constexpr size_t kArenaChunkBytes = 32 * kHugePageBytes;
+constexpr size_t kArenaAlignment = 64;
+
+class HugePageArenaAllocator : public rocksdb::MemoryAllocator {
+ public:
+  explicit HugePageArenaAllocator(bool hugetlb) : hugetlb_(hugetlb) {
+    // Map the first chunk eagerly so that a missing hugetlbfs reservation fails here rather than
+    // inside a block cache insert.
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!MapChunk(hugetlb_)) {
+      throw std::runtime_error(std::string("Failed to map a ") + (hugetlb_ ? "MAP_HUGETLB" : "THP") +
+                               " arena chunk: " + std::strerror(errno) +
+                               (hugetlb_ ? " (reserve pages via /proc/sys/vm/nr_hugepages)" : ""));
+    }
+  }
+
+  ~HugePageArenaAllocator() override {
+    for (const auto& [base, bytes] : chunks_) {
+      munmap(base, bytes);
+    }
+  }
+
+  const char* Name() const override { return hugetlb_ ? "HugetlbArena" : "ThpArena"; }
+
+  // Every block starts with a kArenaAlignment-byte header holding its rounded size and its source.
+  // Nothing here throws: an exception would escape into RocksDB's block cache insert.
+  void* Allocate(size_t size) override {
+    const size_t total = SizeClass(size + kArenaAlignment);
+    char* block = nullptr;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      auto& free_list = free_lists_[total];
+      if (!free_list.empty()) {
+        block = free_list.back();
+        free_list.pop_back();
+      } else if (total <= kArenaChunkBytes && (cursor_ + total <= chunk_end_ || MapChunk(hugetlb_) ||
+                                               (hugetlb_ && MapFallbackChunk()))) {
+        block = cursor_;
+        cursor_ += total;
+      } else {
+        ++malloc_fallbacks_;
+      }
+    }
+    if (block == nullptr) {
+      // malloc's alignment is enough for the block contents; the header only needs to fit.
+      block = static_cast<char*>(std::malloc(total));
+      if (block == nullptr) {
+        // There is no allocator left to fall back on.
+        std::fputs("HugePageArenaAllocator: out of memory\n", stderr);
+        std::abort();
+      }
+      WriteHeader(block, total, kFromMalloc);
+    } else {
+      WriteHeader(block, total, kFromArena);
+    }
+    return block + kArenaAlignment;
+  }
+
+  void Deallocate(void* p) override {
+    char* block = static_cast<char*>(p) - kArenaAlignment;
+    size_t total = 0;
+    size_t source = 0;
+    ReadHeader(block, &total, &source);
+    if (source == kFromMalloc) {
+      std::free(block);
+      return;
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    free_lists_[total].push_back(block);
+  }
+
+  size_t UsableSize(void* p, size_t /*allocation_size*/) const override {
+    size_t total = 0;
+    size_t source = 0;
+    ReadHeader(static_cast<char*>(p) - kArenaAlignment, &total, &source);
+    return total - kArenaAlignment;
+  }
+
+  uint64_t MappedBytes() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return chunks_.size() * kArenaChunkBytes;
+  }
+
+  uint64_t FallbackChunks() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return fallback_chunks_;
+  }
+
+  uint64_t MallocFallbacks() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return malloc_fallbacks_;
+  }
+
+ private:
+  static constexpr size_t kFromArena = 0;
+  static constexpr size_t kFromMalloc = 1;
+
+  static void WriteHeader(char* block, size_t total, size_t source) {
+    std::memcpy(block, &total, sizeof(total));
+    std::memcpy(block + sizeof(total), &source, sizeof(source));
+  }
+
+  static void ReadHeader(const char* block, size_t* total, size_t* source) {
+    std::memcpy(total, block, sizeof(*total));
+    std::memcpy(source, block + sizeof(*total), sizeof(*source));
+  }
+
+  // The hugetlbfs pool ran dry; keep going on THP-advised pages.
+  bool MapFallbackChunk() {
+    if (!MapChunk(false)) {
+      return false;
+    }
+    ++fallback_chunks_;
+    return true;
+  }
+
+  static size_t RoundUp(size_t bytes) { return (bytes + kArenaAlignment - 1) / kArenaAlignment * kArenaAlignment; }
+
+  // Multiples of kArenaAlignment up to 1KB, then four classes per power of two, so rounding wastes
+  // at most a quarter of a block.
+  static size_t SizeClass(size_t bytes) {
+    const size_t rounded = RoundUp(bytes);
+    if (rounded <= 1024) {
+      return rounded;
+    }
+    const size_t step = size_t{1} << (63 - __builtin_clzll(rounded) - 2);
+    return (rounded + step - 1) / step * step;
+  }
+
+  // Maps a new chunk and makes it current. THP chunks are over-mapped by one huge page and trimmed
+  // so the khugepaged-eligible range starts on a 2MB boundary.
+  bool MapChunk(bool hugetlb) {
+    char* base = nullptr;
+    if (hugetlb) {
+#if defined(MAP_HUGETLB)
+      void* mapped = mmap(nullptr, kArenaChunkBytes, PROT_READ | PROT_WRITE,
+                          MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+      if (mapped == MAP_FAILED) {
+        return false;
+      }
+      base = static_cast<char*>(mapped);
+#else
+      errno = ENOTSUP;
+      return false;
+#endif
+    } else {
+      const size_t span = kArenaChunkBytes + kHugePageBytes;
+      void* mapped = mmap(nullptr, span, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+      if (mapped == MAP_FAILED) {
+        return false;
+      }
+      char* raw = static_cast<char*>(mapped);
+      const uintptr_t misalign = reinterpret_cast<uintptr_t>(raw) % kHugePageBytes;
+      const size_t head = misalign == 0 ? 0 : kHugePageBytes - misalign;
+      base = raw + head;
+      if (head > 0) {
+        munmap(raw, head);
+      }
+      if (kHugePageBytes - head > 0) {
+        munmap(base + kArenaChunkBytes, kHugePageBytes - head);
+      }
+#if defined(MADV_HUGEPAGE)
+      madvise(base, kArenaChunkBytes, MADV_HUGEPAGE);
+#endif
+    }
+    chunks_.emplace_back(base, kArenaChunkBytes);
+    cursor_ = base;
+    chunk_end_ = base + kArenaChunkBytes;
+    return true;
+  }
+
+  const bool hugetlb_;
+  mutable std::mutex mutex_;
+  std::vector<std::pair<char*, size_t>> chunks_;
+  std::unordered_map<size_t, std::vector<char*>> free_lists_;
+  char* cursor_ = nullptr;
+  char* chunk_end_ = nullptr;
+  uint64_t fallback_chunks_ = 0;
+  uint64_t malloc_fallbacks_ = 0;
+};
+
+// Counts dTLB load misses on the calling thread via perf_event_open. Containers and
+// perf_event_paranoid often forbid it, in which case Available() is false.
+class DtlbMissCounter {
+ public:
+  DtlbMissCounter() {
+#if defined(__linux__)
+    perf_event_attr attr{};
+    attr.type = PERF_TYPE_HW_CACHE;
+    attr.size = sizeof(attr);
+    attr.config = PERF_COUNT_HW_CACHE_DTLB | (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                  (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+    attr.disabled = 1;
+    attr.exclude_hv = 1;
+    fd_ = static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+#endif
+  }
+
+  ~DtlbMissCounter() {
+    if (fd_ >= 0) {
+      close(fd_);
+    }
+  }
+
+  bool Available() const { return fd_ >= 0; }
+
+  void Start() {
+#if defined(__linux__)
+    if (fd_ >= 0) {
+      ioctl(fd_, PERF_EVENT_IOC_RESET, 0);
+      ioctl(fd_, PERF_EVENT_IOC_ENABLE, 0);
+    }
+#endif
+  }
+
+  uint64_t Stop() {
+    uint64_t count = 0;
+#if defined(__linux__)
+    if (fd_ >= 0) {
+      ioctl(fd_, PERF_EVENT_IOC_DISABLE, 0);
+      if (read(fd_, &count, sizeof(count)) != static_cast<ssize_t>(sizeof(count))) {
+        count = 0;
+      }
+    }
+#endif
+    return count;
+  }
+
+ private:
+  int fd_ = -1;
+};
+
+// Below this data-block hit ratio the random reads are not served from the cache, so the
+// allocator comparison would be measuring I/O instead.
+constexpr double kMinCachedHitRatio = 0.99;
+
+// Compression is off, so cached blocks are about as large as the SST files; the headroom covers
+// index and filter blocks, cache entry metadata and allocator rounding.
+uint64_t CacheAllocatorCapacity(const Config& cfg, uint64_t total_sst_bytes) {
+  if (cfg.block_cache_bytes > 0) {
+    return cfg.block_cache_bytes;
+  }
+  return total_sst_bytes + total_sst_bytes / 4 + 64ull * 1024ull * 1024ull;
+}
+
+// Reopens the DB with a block cache of `cache_bytes` backed by `allocator`, fills it with a
+// sequential scan, then times cfg.read_ops uniform random Gets that are served from the cache.
+AllocatorStats MeasureCacheAllocator(const std::filesystem::path& db_path, const rocksdb::Options& template_options,
+                                     const Config& cfg, int block_size, uint64_t cache_bytes,
+                                     CacheAllocator allocator) {
+  AllocatorStats stats;
+  stats.allocator = CacheAllocatorName(allocator);
+  stats.cache_bytes = cache_bytes;
+  std::shared_ptr<HugePageArenaAllocator> arena;
+  if (allocator != CacheAllocator::kDefault) {
+    arena = std::make_shared<HugePageArenaAllocator>(allocator == CacheAllocator::kHugetlb);
+  }
+
+  rocksdb::Options options = template_options;
+  options.create_if_missing = false;
+  options.error_if_exists = false;
+  options.statistics = rocksdb::CreateDBStatistics();
+  rocksdb::LRUCacheOptions cache_options;
+  cache_options.capacity = cache_bytes;
+  cache_options.memory_allocator = arena;
+  rocksdb::BlockBasedTableOptions table_options = BuildTableOptions(cfg, block_size);
+  table_options.no_block_cache = false;
+  table_options.block_cache = rocksdb::NewLRUCache(cache_options);
+  options.table_factory.reset(NewBlockBasedTableFactory(table_options));
+
+  rocksdb::DB* raw_db = nullptr;
+  auto status = rocksdb::DB::OpenForReadOnly(options, db_path.string(), &raw_db);
+  if (!status.ok()) {
+    throw std::runtime_error("Failed to reopen RocksDB for the allocator benchmark at " + db_path.string() +
+                             ": " + status.ToString());
+  }
+  std::unique_ptr<rocksdb::DB> db(raw_db);
+  rocksdb::Statistics* statistics = options.statistics.get();
+
+  rocksdb::ReadOptions read_options;
+  read_options.verify_checksums = false;
+  {
+    std::unique_ptr<rocksdb::Iterator> it(db->NewIterator(read_options));
+    for (it->SeekToFirst(); it->Valid(); it->Next()) {
+    }
+    if (!it->status().ok()) {
+      throw std::runtime_error("Cache fill scan failed: " + it->status().ToString());
+    }
+  }
+
+  std::mt19937_64 rng(0xC0FFEE);
+  std::uniform_int_distribution<uint64_t> dist(0, kEntryCount - 1);
+  std::array<char, kKeySize + 1> key_buffer{};
+  rocksdb::PinnableSlice value;
+  const uint64_t hits_before = statistics->getTickerCount(rocksdb::BLOCK_CACHE_DATA_HIT);
+  const uint64_t misses_before = statistics->getTickerCount(rocksdb::BLOCK_CACHE_DATA_MISS);
+  DtlbMissCounter dtlb;
+  auto start = std::chrono::steady_clock::now();
+  dtlb.Start();
+  for (uint64_t i = 0; i < cfg.read_ops; ++i) {
+    FormatKey(dist(rng), &key_buffer);
+    status = db->Get(read_options, db->DefaultColumnFamily(), rocksdb::Slice(key_buffer.data(), kKeySize),
+                     &value);
+    if (!status.ok()) {
+      throw std::runtime_error("Read failed: " + status.ToString());
+    }
+    value.Reset();
+  }
+  const uint64_t dtlb_misses = dtlb.Stop();
+  const double seconds =
+      std::max(1e-9, std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+  const uint64_t hits = statistics->getTickerCount(rocksdb::BLOCK_CACHE_DATA_HIT) - hits_before;
+  const uint64_t misses = statistics->getTickerCount(rocksdb::BLOCK_CACHE_DATA_MISS) - misses_before;
+  stats.ops_per_sec = static_cast<double>(cfg.read_ops) / seconds;
+  stats.hit_ratio = hits + misses == 0 ? 0.0 : static_cast<double>(hits) / static_cast<double>(hits + misses);
+  if (dtlb.Available() && cfg.read_ops > 0) {
+    stats.dtlb_misses_per_op = static_cast<double>(dtlb_misses) / static_cast<double>(cfg.read_ops);
+  }
+  db.reset();
+  if (arena) {
+    stats.arena_bytes = arena->MappedBytes();
+    stats.fallback_chunks = arena->FallbackChunks();
+    stats.malloc_fallbacks = arena->MallocFallbacks();
+  }
+  return stats;
+}
+
+std::vector<AllocatorStats> BenchmarkCacheAllocators(const std::filesystem::path& db_path,
+                                                     const rocksdb::Options& options, const Config& cfg,
+                                                     int block_size, uint64_t total_sst_bytes) {
+  const uint64_t cache_bytes = CacheAllocatorCapacity(cfg, total_sst_bytes);
+  std::vector<AllocatorStats> stats;
+  for (CacheAllocator allocator : cfg.cache_allocators) {
+    std::cout << "[block=" << block_size << "] cached reads with the " << CacheAllocatorName(allocator)
+              << " allocator...\n";
+    stats.push_back(MeasureCacheAllocator(db_path, options, cfg, block_size, cache_bytes, allocator));
+  }
+  return stats;
+}
+
+// The deleted region is the key prefix [0, deleted_end), like a TTL sweep over the oldest data.
+constexpr uint64_t kDeleteGetOps = 20'000;
+constexpr uint64_t kDeleteScanOps = 100;
+constexpr int kDeleteScanRows = 100;
+
+struct DeletedRegionProbe {
+  double get_us = 0.0;
+  double scan_us = 0.0;
+  double skipped_per_scan = 0.0;
+};
+
+// Point lookups land inside the deleted region; scans start at a random deleted key and read
+// kDeleteScanRows live rows, so they must step over every tombstone up to the region's end.
+DeletedRegionProbe ProbeDeletedRegion(rocksdb::DB* db, uint64_t deleted_end) {
+  DeletedRegionProbe probe;
+  rocksdb::ReadOptions read_options;
+  read_options.fill_cache = false;
+  read_options.verify_checksums = false;
+  std::mt19937_64 rng(0xDE1E7E);
+  std::uniform_int_distribution<uint64_t> dist(0, deleted_end - 1);
+  std::array<char, kKeySize + 1> key_buffer{};
+  rocksdb::PinnableSlice value;
+
+  auto start = std::chrono::steady_clock::now();
+  for (uint64_t i = 0; i < kDeleteGetOps; ++i) {
+    FormatKey(dist(rng), &key_buffer);
+    auto status = db->Get(read_options, db->DefaultColumnFamily(), rocksdb::Slice(key_buffer.data(), kKeySize),
+                          &value);
+    if (!status.ok() && !status.IsNotFound()) {
+      throw std::runtime_error("Read failed: " + status.ToString());
+    }
+    value.Reset();
+  }
+  auto end = std::chrono::steady_clock::now();
+  probe.get_us = std::chrono::duration<double, std::micro>(end - start).count() / kDeleteGetOps;
+
+  rocksdb::SetPerfLevel(rocksdb::PerfLevel::kEnableCount);
+  rocksdb::get_perf_context()->Reset();
+  start = std::chrono::steady_clock::now();
+  for (uint64_t i = 0; i < kDeleteScanOps; ++i) {
+    FormatKey(dist(rng), &key_buffer);
+    std::unique_ptr<rocksdb::Iterator> it(db->NewIterator(read_options));
+    int rows = 0;
+    for (it->Seek(rocksdb::Slice(key_buffer.data(), kKeySize)); it->Valid() && rows < kDeleteScanRows; it->Next()) {
+      ++rows;
+    }
+    if (!it->status().ok()) {
+      throw std::runtime_error("Scan failed: " + it->status().ToString());
+    }
+  }
+  end = std::chrono::steady_clock::now();
+  const rocksdb::PerfContext* perf = rocksdb::get_perf_context();
+  probe.skipped_per_scan = static_cast<double>(perf->internal_delete_skipped_count +
+                                               perf->internal_range_del_reseek_count) / kDeleteScanOps;
+  rocksdb::SetPerfLevel(rocksdb::PerfLevel::kDisable);
+  probe.scan_us = std::chrono::duration<double, std::micro>(end - start).count() / kDeleteScanOps;
+  return probe;
+}
+
+void ApplyDeletes(rocksdb::DB* db, DeleteKind kind, uint64_t deleted_end) {
+  rocksdb::WriteOptions write_options;
+  write_options.disableWAL = true;
+  std::array<char, kKeySize + 1> key_buffer{};
+  rocksdb::Status status;
+  if (kind == DeleteKind::kRange) {
+    std::array<char, kKeySize + 1> end_buffer{};
+    FormatKey(0, &key_buffer);
+    FormatKey(deleted_end, &end_buffer);
+    status = db->DeleteRange(write_options, db->DefaultColumnFamily(), rocksdb::Slice(key_buffer.data(), kKeySize),
+                             rocksdb::Slice(end_buffer.data(), kKeySize));
+    if (!status.ok()) {
+      throw std::runtime_error("DeleteRange failed: " + status.ToString());
+    }
+    return;
+  }
+  rocksdb::WriteBatch batch;
+  for (uint64_t i = 0; i < deleted_end; ++i) {
+    FormatKey(i, &key_buffer);
+    rocksdb::Slice key_slice(key_buffer.data(), kKeySize);
+    if (kind == DeleteKind::kSingle) {
+      batch.SingleDelete(key_slice);
+    } else {
+      batch.Delete(key_slice);
+    }
+    if (batch.Count() >= 1'000 || i + 1 == deleted_end) {
+      status = db->Write(write_options, &batch);
+      if (!status.ok()) {
+        throw std::runtime_error("Delete failed: " + status.ToString());
+      }
+      batch.Clear();
+    }
+  }
+}
+
+uint64_t TotalSstBytes(rocksdb::DB* db) {
+  uint64_t bytes = 0;
+  if (!db->GetAggregatedIntProperty("rocksdb.total-sst-files-size", &bytes)) {
+    throw std::runtime_error("Failed to get rocksdb.total-sst-files-size");
+  }
+  return bytes;
+}
+
+// Each delete kind works on its own checkpoint (hard links) of the compacted DB, so the base stays
+// intact for the next kind. Auto-compaction is off so the "before" numbers see every tombstone.
+std::vector<DeleteStats> BenchmarkDeletes(const std::filesystem::path& db_path, const rocksdb::Options& template_options,
+                                          const Config& cfg, int block_size) {
+  std::vector<DeleteStats> stats;
+  const uint64_t deleted_end = std::min<uint64_t>(
+      kEntryCount, static_cast<uint64_t>(cfg.delete_fraction * static_cast<double>(kEntryCount)));
+  if (deleted_end == 0) {
+    return stats;
+  }
+  rocksdb::Options options = template_options;
+  options.create_if_missing = false;
+  options.error_if_exists = false;
+  options.disable_auto_compactions = true;
+
+  for (DeleteKind kind : cfg.delete_kinds) {
+    std::cout << "[block=" << block_size << "] deleting " << deleted_end << " keys with "
+              << DeleteKindName(kind) << "...\n";
+    const std::filesystem::path copy_path =
+        cfg.db_root / ("block_" + std::to_string(block_size) + "_del_" + DeleteKindName(kind));
+    CreateCheckpointCopy(options, db_path, copy_path);
+
+    rocksdb::DB* raw_db = nullptr;
+    auto status = rocksdb::DB::Open(options, copy_path.string(), &raw_db);
+    if (!status.ok()) {
+      throw std::runtime_error("Failed to open checkpoint at " + copy_path.string() + ": " + status.ToString());
+    }
+    std::unique_ptr<rocksdb::DB> db(raw_db);
+
+    DeleteStats entry;
+    entry.kind = kind;
+    auto start = std::chrono::steady_clock::now();
+    ApplyDeletes(db.get(), kind, deleted_end);
+    rocksdb::FlushOptions flush_options;
+    flush_options.wait = true;
+    status = db->Flush(flush_options);
+    if (!status.ok()) {
+      throw std::runtime_error("Flush failed: " + status.ToString());
+    }
+    entry.delete_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    entry.sst_bytes_before = TotalSstBytes(db.get());
+    DeletedRegionProbe before = ProbeDeletedRegion(db.get(), deleted_end);
+    entry.get_us_before = before.get_us;
+    entry.scan_us_before = before.scan_us;
+    entry.skipped_per_scan_before = before.skipped_per_scan;
+
+    start = std::chrono::steady_clock::now();
+    status = db->CompactRange(rocksdb::CompactRangeOptions(), nullptr, nullptr);
+    if (!status.ok()) {
+      throw std::runtime_error("CompactRange failed: " + status.ToString());
+    }
+    entry.compaction_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    entry.sst_bytes_after = TotalSstBytes(db.get());
+    DeletedRegionProbe after = ProbeDeletedRegion(db.get(), deleted_end);
+    entry.get_us_after = after.get_us;
+    entry.scan_us_after = after.scan_us;
+    entry.skipped_per_scan_after = after.skipped_per_scan;
+    stats.push_back(entry);
+
+    db.reset();
+    std::filesystem::remove_all(copy_path);
+  }
+  return stats;
+}
+
+void LoadPositions(rocksdb::DB* db, InsertOrder order, const FeistelPermutation& permutation,
+                   uint64_t begin, uint64_t end, bool user_timestamps) {
+  rocksdb::WriteOptions write_options;
+  write_options.disableWAL = true;
+  rocksdb::WriteBatch batch;
+  const size_t batch_size = 1'000;
+  std::array<char, kKeySize + 1> key_buffer{};
+  std::array<char, kValueSize> value_buffer{};
+  const auto write_ts = EncodeTimestamp(kLoadTimestamp);
+  const rocksdb::Slice write_ts_slice(write_ts.data(), write_ts.size());
+  rocksdb::Status status;
+
+  for (uint64_t position = begin; position < end; ++position) {
+    const uint64_t i = KeyAtPosition(order, permutation, position);
+    FormatKey(i, &key_buffer);
+    FillValue(i, &value_buffer);
+    rocksdb::Slice key_slice(key_buffer.data(), kKeySize);
+    rocksdb::Slice value_slice(value_buffer.data(), kValueSize);
+    if (user_timestamps) {
+      batch.Put(db->DefaultColumnFamily(), key_slice, write_ts_slice, value_slice);
+    } else {
+      batch.Put(key_slice, value_slice);
+    }
+    if (batch.Count() >= static_cast<int>(batch_size)) {
+      status = db->Write(write_options, &batch);
+      if (!status.ok()) {
+        throw std::runtime_error("Write failed: " + status.ToString());
+      }
+      batch.Clear();
+    }
+  }
+  if (batch.Count() > 0) {
+    status = db->Write(write_options, &batch);
+    if (!status.ok()) {
+      throw std::runtime_error("Write failed: " + status.ToString());
+    }
+    batch.Clear();
+  }
+}
+
+// Files per non-empty level, e.g. "L0:2 L5:3 L6:14".
+std::string DescribeLayout(rocksdb::DB* db) {
+  rocksdb::ColumnFamilyMetaData metadata;
+  db->GetColumnFamilyMetaData(&metadata);
+  std::string layout;
+  for (const auto& level : metadata.levels) {
+    if (level.files.empty()) {
+      continue;
+    }
+    if (!layout.empty()) {
+      layout += ' ';
+    }
+    layout += "L" + std::to_string(level.level) + ":" + std::to_string(level.files.size());
+  }
+  return layout.empty() ? "empty" : layout;
+}
+
+// With user_timestamps, every key carries an 8-byte u64 timestamp, so internal keys and index
+// separators grow by kTimestampSize.
+Result RunOnce(const Config& cfg, int block_size, bool user_timestamps = false) {
+  Result result;
+  result.block_size = block_size;
+  const std::filesystem::path db_path =
+      cfg.db_root / ("block_" + std::to_string(block_size) + (user_timestamps ? "_udt" : ""));
+  std::filesystem::create_directories(cfg.db_root);
+  if (std::filesystem::exists(db_path)) {
+    std::filesystem::remove_all(db_path);
+  }
+
+  rocksdb::Options options = BuildOptions(cfg, block_size);
+  if (user_timestamps) {
+    options.comparator = rocksdb::BytewiseComparatorWithU64Ts();
+  }
+  // Only the load counts flush and compaction bytes; the later phases reopen from `options` and
+  // must not add to, or pay for, these tickers.
+  rocksdb::Options load_options = options;
+  load_options.statistics = rocksdb::CreateDBStatistics();
+  rocksdb::DB* raw_db = nullptr;
+  auto status = rocksdb::DB::Open(load_options, db_path.string(), &raw_db);
+  if (!status.ok()) {
+    throw std::runtime_error("Failed to open RocksDB at " + db_path.string() + ": " + status.ToString());
+  }
+  std::unique_ptr<rocksdb::DB> db(raw_db);
+
+  auto ingest_start = std::chrono::steady_clock::now();
+  const FeistelPermutation permutation(kEntryCount, 0x5EED);
+  const uint64_t per_thread = (kEntryCount + cfg.load_threads - 1) / cfg.load_threads;
+  std::vector<std::thread> loaders;
+  std::vector<std::exception_ptr> errors(cfg.load_threads);
+  for (int t = 0; t < cfg.load_threads; ++t) {
+    const uint64_t begin = std::min(kEntryCount, per_thread * t);
+    const uint64_t end = std::min(kEntryCount, begin + per_thread);
+    loaders.emplace_back([&, t, begin, end]() {
+      try {
+        LoadPositions(db.get(), cfg.insert_order, permutation, begin, end, user_timestamps);
+      } catch (...) {
+        errors[t] = std::current_exception();
+      }
+    });
+  }
+  for (auto& loader : loaders) {
+    loader.join();
+  }
+  for (const auto& error : errors) {
+    if (error) {
+      std::rethrow_exception(error);
+    }
+  }
+
+  rocksdb::FlushOptions flush_options;
+  flush_options.wait = true;
+  status = db->Flush(flush_options);
+  if (!status.ok()) {
+    throw std::runtime_error("Flush failed: " + status.ToString());
+  }
+  status = db->WaitForCompact(rocksdb::WaitForCompactOptions());
+  if (!status.ok()) {
+    throw std::runtime_error("WaitForCompact failed: " + status.ToString());
+  }
+  result.ingest_seconds =
+      std::chrono::duration<double>(std::chrono::steady_clock::now() - ingest_start).count();
+  const uint64_t ingest_bytes_written = load_options.statistics->getTickerCount(rocksdb::FLUSH_WRITE_BYTES) +
+                                        load_options.statistics->getTickerCount(rocksdb::COMPACT_WRITE_BYTES);
+  result.write_amplification = static_cast<double>(ingest_bytes_written) /
+                               static_cast<double>(kRawPayloadBytes);
+  result.ingest_layout = DescribeLayout(db.get());
+
+  status = db->CompactRange(rocksdb::CompactRangeOptions(), nullptr, nullptr);
+  if (!status.ok()) {
+    throw std::runtime_error("CompactRange failed: " + status.ToString());
   }
   if (!db->GetAggregatedIntProperty("rocksdb.total-sst-files-size", &result.total_sst_bytes)) {
     throw std::runtime_error("Failed to get rocksdb.total-sst-files-size");
@@ -271,6 +2007,15 @@ Result RunOnce(const Config& cfg, int block_size) {
   if (!db->GetAggregatedIntProperty("rocksdb.estimate-table-readers-mem", &result.table_readers_mem)) {
     throw std::runtime_error("Failed to get rocksdb.estimate-table-readers-mem");
   }
+  rocksdb::TablePropertiesCollection table_properties;
+  status = db->GetPropertiesOfAllTables(&table_properties);
+  if (!status.ok()) {
+    throw std::runtime_error("Failed to get table properties: " + status.ToString());
+  }
+  for (const auto& [path, props] : table_properties) {
+    result.data_bytes += props->data_size;
+    result.index_bytes += props->index_size;
+  }
   result.amplification = static_cast<double>(result.total_sst_bytes) /
                          static_cast<double>(kRawPayloadBytes);
 
@@ -278,8 +2023,23 @@ Result RunOnce(const Config& cfg, int block_size) {
   if (cfg.read_ops > 0) {
     std::cout << "[block=" << block_size << "] ingest complete, starting read benchmark ("
               << cfg.read_ops << " ops)...\n";
-    ReadStats read_stats = BenchmarkReads(db_path, options, cfg.read_ops);
+    ReadStats read_stats = BenchmarkReads(db_path, options, cfg, block_size);
     result.read_ops_per_sec = read_stats.ops_per_sec;
+    result.residency_before = read_stats.residency_before;
+    result.residency_after = read_stats.residency_after;
+    result.cache_trace_path = read_stats.cache_trace_path;
+    if (cfg.warmup) {
+      result.warmup = BenchmarkWarmup(db_path, options, cfg, block_size);
+    }
+    if (!cfg.cache_allocators.empty()) {
+      result.allocators = BenchmarkCacheAllocators(db_path, options, cfg, block_size, result.total_sst_bytes);
+    }
+  }
+  if (!cfg.scan_threads.empty()) {
+    result.scans = BenchmarkParallelScans(db_path, options, cfg, block_size);
+  }
+  if (cfg.delete_fraction > 0.0) {
+    result.deletes = BenchmarkDeletes(db_path, options, cfg, block_size);
   }
   if (!cfg.keep_dbs) {
     std::filesystem::remove_all(db_path);
@@ -287,11 +2047,739 @@ Result RunOnce(const Config& cfg, int block_size) {
   return result;
 }
 
+// ---------------------------------------------------------------------------------------------
+// Block-size advisor.
+//
+// Each candidate (block size x index type x filter) is loaded at trial scale with the requested
+// key/value geometry, then read with a block cache sized to the memory budget scaled down by the
+// same factor as the dataset, so the cached fraction of the data matches the full deployment.
+// The trial runs against a warm page cache, which makes its wall time a CPU cost; every block cache
+// miss is then charged the device's latency and transfer time to predict full-scale throughput.
+
+struct DeviceProfile {
+  const char* name;
+  double read_latency_us;
+  double bandwidth_mb_per_sec;
+};
+
+constexpr DeviceProfile kDeviceProfiles[] = {
+    {"nvme", 80.0, 2000.0},
+    {"ssd", 200.0, 500.0},
+    {"hdd", 8000.0, 150.0},
+};
+
+const DeviceProfile& LookupDevice(const std::string& name) {
+  for (const auto& device : kDeviceProfiles) {
+    if (name == device.name) {
+      return device;
+    }
+  }
+  throw std::runtime_error("Unknown device profile: " + name);
+}
+
+constexpr uint64_t kTrialOps = 20'000;
+constexpr int kTrialScanLength = 100;
+constexpr int kTrialBloomBitsPerKey = 10;
+
+struct TrialConfig {
+  int block_size = 0;
+  bool partitioned_index = false;
+  int bloom_bits_per_key = 0;
+};
+
+struct TrialResult {
+  TrialConfig config;
+  double amplification = 0.0;
+  uint64_t full_scale_table_mem = 0;
+  uint64_t full_scale_cache_bytes = 0;
+  bool fits = false;
+  double misses_per_op = 0.0;
+  double bytes_per_op = 0.0;
+  double cpu_us_per_op = 0.0;
+  double predicted_ops_per_sec = 0.0;
+};
+
+std::string DescribeTrial(const TrialConfig& config) {
+  std::string out = config.partitioned_index ? "partitioned" : "binary_search";
+  out += config.bloom_bits_per_key > 0 ? " bloom" + std::to_string(config.bloom_bits_per_key) : " no_filter";
+  return out;
+}
+
+rocksdb::BlockBasedTableOptions BuildTrialTableOptions(const Config& cfg, const TrialConfig& config) {
+  rocksdb::BlockBasedTableOptions table_options = BuildTableOptions(cfg, config.block_size);
+  if (config.partitioned_index) {
+    table_options.index_type = rocksdb::BlockBasedTableOptions::kTwoLevelIndexSearch;
+    table_options.partition_filters = config.bloom_bits_per_key > 0;
+  }
+  if (config.bloom_bits_per_key > 0) {
+    table_options.filter_policy.reset(rocksdb::NewBloomFilterPolicy(config.bloom_bits_per_key));
+  }
+  return table_options;
+}
+
+// Trial keys are zero-padded decimal indexes of the requested width; absent keys replace the last
+// digit with 'x', which sorts between two neighbouring keys.
+std::string TrialKey(uint64_t index, size_t key_size) {
+  std::string key(key_size, '0');
+  for (size_t pos = key_size; pos > 0 && index > 0; --pos, index /= 10) {
+    key[pos - 1] = static_cast<char>('0' + index % 10);
+  }
+  return key;
+}
+
+void WarmPageCache(const std::filesystem::path& db_path) {
+  std::vector<char> buffer(1 << 20);
+  for (const auto& entry : std::filesystem::directory_iterator(db_path)) {
+    if (entry.path().extension() != ".sst") {
+      continue;
+    }
+    std::ifstream in(entry.path(), std::ios::binary);
+    while (in.read(buffer.data(), static_cast<std::streamsize>(buffer.size())) || in.gcount() > 0) {
+    }
+  }
+}
+
+TrialResult RunTrial(const Config& cfg, const TrialConfig& config, uint64_t entries, double scale,
+                     const DeviceProfile& device) {
+  TrialResult result;
+  result.config = config;
+  const std::filesystem::path db_path = cfg.db_root / "advise_trial";
+  if (std::filesystem::exists(db_path)) {
+    std::filesystem::remove_all(db_path);
+  }
+
+  rocksdb::Options options = BuildOptions(cfg, config.block_size);
+  options.table_factory.reset(NewBlockBasedTableFactory(BuildTrialTableOptions(cfg, config)));
+  rocksdb::DB* raw_db = nullptr;
+  auto status = rocksdb::DB::Open(options, db_path.string(), &raw_db);
+  if (!status.ok()) {
+    throw std::runtime_error("Failed to open trial DB at " + db_path.string() + ": " + status.ToString());
+  }
+  std::unique_ptr<rocksdb::DB> db(raw_db);
+  rocksdb::WriteOptions write_options;
+  write_options.disableWAL = true;
+  rocksdb::WriteBatch batch;
+  std::string value(cfg.value_size, '\0');
+  for (uint64_t i = 0; i < entries; ++i) {
+    for (size_t j = 0; j < cfg.value_size; ++j) {
+      value[j] = static_cast<char>('a' + ((i + j) % 26));
+    }
+    batch.Put(TrialKey(i, cfg.key_size), value);
+    if (batch.Count() >= 1'000 || i + 1 == entries) {
+      status = db->Write(write_options, &batch);
+      if (!status.ok()) {
+        throw std::runtime_error("Trial write failed: " + status.ToString());
+      }
+      batch.Clear();
+    }
+  }
+  rocksdb::FlushOptions flush_options;
+  flush_options.wait = true;
+  status = db->Flush(flush_options);
+  if (status.ok()) {
+    status = db->CompactRange(rocksdb::CompactRangeOptions(), nullptr, nullptr);
+  }
+  if (!status.ok()) {
+    throw std::runtime_error("Trial flush/compaction failed: " + status.ToString());
+  }
+  uint64_t sst_bytes = 0;
+  uint64_t table_mem = 0;
+  if (!db->GetAggregatedIntProperty("rocksdb.total-sst-files-size", &sst_bytes)) {
+    throw std::runtime_error("Failed to get rocksdb.total-sst-files-size");
+  }
+  if (!db->GetAggregatedIntProperty("rocksdb.estimate-table-readers-mem", &table_mem)) {
+    throw std::runtime_error("Failed to get rocksdb.estimate-table-readers-mem");
+  }
+  db.reset();
+  result.amplification = static_cast<double>(sst_bytes) /
+                         static_cast<double>(entries * (cfg.key_size + cfg.value_size));
+
+  // Partitioned index/filter blocks live in the block cache, so they compete with data blocks for
+  // the budget; unpartitioned ones are held by the table readers and come off the top.
+  const double trial_budget = static_cast<double>(cfg.memory_budget) / scale;
+  result.full_scale_table_mem = static_cast<uint64_t>(static_cast<double>(table_mem) * scale);
+  result.fits = static_cast<double>(table_mem) < trial_budget;
+  if (!result.fits) {
+    std::filesystem::remove_all(db_path);
+    return result;
+  }
+  const uint64_t trial_cache_bytes = static_cast<uint64_t>(trial_budget) - table_mem;
+  result.full_scale_cache_bytes = cfg.memory_budget - result.full_scale_table_mem;
+
+  rocksdb::Options read_options_template = options;
+  read_options_template.create_if_missing = false;
+  read_options_template.error_if_exists = false;
+  read_options_template.use_direct_reads = false;
+  read_options_template.statistics = rocksdb::CreateDBStatistics();
+  rocksdb::BlockBasedTableOptions table_options = BuildTrialTableOptions(cfg, config);
+  table_options.no_block_cache = false;
+  table_options.block_cache = rocksdb::NewLRUCache(trial_cache_bytes);
+  if (config.partitioned_index) {
+    table_options.cache_index_and_filter_blocks = true;
+    table_options.pin_top_level_index_and_filter = true;
+  }
+  read_options_template.table_factory.reset(NewBlockBasedTableFactory(table_options));
+  status = rocksdb::DB::OpenForReadOnly(read_options_template, db_path.string(), &raw_db);
+  if (!status.ok()) {
+    throw std::runtime_error("Failed to reopen trial DB: " + status.ToString());
+  }
+  db.reset(raw_db);
+  WarmPageCache(db_path);
+
+  rocksdb::ReadOptions read_options;
+  read_options.verify_checksums = false;
+  std::mt19937_64 rng(0xADB15E);
+  std::uniform_int_distribution<uint64_t> key_dist(0, entries - 1);
+  std::uniform_real_distribution<double> op_dist(0.0, 1.0);
+  rocksdb::PinnableSlice found;
+  auto run_ops = [&](uint64_t ops) {
+    for (uint64_t i = 0; i < ops; ++i) {
+      const double pick = op_dist(rng);
+      std::string key = TrialKey(key_dist(rng), cfg.key_size);
+      if (pick < cfg.scan_fraction) {
+        std::unique_ptr<rocksdb::Iterator> it(db->NewIterator(read_options));
+        int rows = 0;
+        for (it->Seek(key); it->Valid() && rows < kTrialScanLength; it->Next()) {
+          ++rows;
+        }
+        continue;
+      }
+      if (pick < cfg.scan_fraction + cfg.absent_fraction) {
+        key.back() = 'x';
+      }
+      auto get_status = db->Get(read_options, db->DefaultColumnFamily(), key, &found);
+      if (!get_status.ok() && !get_status.IsNotFound()) {
+        throw std::runtime_error("Trial read failed: " + get_status.ToString());
+      }
+      found.Reset();
+    }
+  };
+  run_ops(kTrialOps);  // Warm the block cache to its steady state.
+  rocksdb::Statistics* statistics = read_options_template.statistics.get();
+  const uint64_t misses_before = statistics->getTickerCount(rocksdb::BLOCK_CACHE_MISS);
+  rocksdb::get_iostats_context()->Reset();
+  auto start = std::chrono::steady_clock::now();
+  run_ops(kTrialOps);
+  auto end = std::chrono::steady_clock::now();
+  const uint64_t misses = statistics->getTickerCount(rocksdb::BLOCK_CACHE_MISS) - misses_before;
+  const uint64_t bytes_read = rocksdb::get_iostats_context()->bytes_read;
+  db.reset();
+  std::filesystem::remove_all(db_path);
+
+  const double ops = static_cast<double>(kTrialOps);
+  result.cpu_us_per_op = std::chrono::duration<double, std::micro>(end - start).count() / ops;
+  result.misses_per_op = static_cast<double>(misses) / ops;
+  result.bytes_per_op = static_cast<double>(bytes_read) / ops;
+  const double io_us_per_op = result.misses_per_op * device.read_latency_us +
+                              result.bytes_per_op / device.bandwidth_mb_per_sec;  // 1 MB/s == 1 B/us.
+  result.predicted_ops_per_sec = 1e6 / std::max(1e-3, result.cpu_us_per_op + io_us_per_op);
+  return result;
+}
+
+void RunAdvisor(const Config& cfg) {
+  if (cfg.key_size < 8 || cfg.value_size == 0) {
+    throw std::runtime_error("--advise needs --key_size >= 8 and a non-empty --value_size");
+  }
+  const DeviceProfile& device = LookupDevice(cfg.device);
+  const uint64_t full_entries = cfg.dataset_bytes / (cfg.key_size + cfg.value_size);
+  const uint64_t entries = std::max<uint64_t>(1, std::min(full_entries, cfg.trial_entries));
+  const double scale = static_cast<double>(full_entries) / static_cast<double>(entries);
+  std::filesystem::create_directories(cfg.db_root);
+
+  std::cout << "Advising for " << HumanBytes(static_cast<double>(cfg.dataset_bytes)) << " (" << full_entries
+            << " x " << cfg.key_size << "B/" << cfg.value_size << "B), memory budget "
+            << HumanBytes(static_cast<double>(cfg.memory_budget)) << ", device " << device.name
+            << ", trials at 1/" << std::fixed << std::setprecision(1) << scale << " scale\n";
+  std::vector<TrialResult> trials;
+  for (int block_size : cfg.block_sizes) {
+    for (bool partitioned : {false, true}) {
+      for (int bloom_bits : {0, kTrialBloomBitsPerKey}) {
+        TrialConfig config{block_size, partitioned, bloom_bits};
+        std::cout << "[advise] block=" << block_size << " " << DescribeTrial(config) << "...\n";
+        trials.push_back(RunTrial(cfg, config, entries, scale, device));
+      }
+    }
+  }
+
+  std::sort(trials.begin(), trials.end(), [](const TrialResult& a, const TrialResult& b) {
+    return a.predicted_ops_per_sec > b.predicted_ops_per_sec;
+  });
+  std::cout << std::left << std::setw(12) << "Block Size"
+            << std::setw(24) << "Index/Filter"
+            << std::right << std::setw(10) << "Amplif."
+            << std::setw(12) << "Table Mem"
+            << std::setw(12) << "Cache"
+            << std::setw(12) << "Miss/Op"
+            << std::setw(12) << "CPU us/Op"
+            << std::setw(14) << "Pred. Ops/s" << "\n";
+  for (const auto& t : trials) {
+    std::cout << std::left << std::setw(12) << HumanBytes(t.config.block_size)
+              << std::setw(24) << DescribeTrial(t.config)
+              << std::right << std::setw(10) << std::fixed << std::setprecision(2) << t.amplification
+              << std::setw(12) << HumanBytes(static_cast<double>(t.full_scale_table_mem));
+    if (!t.fits) {
+      std::cout << std::setw(12) << "over budget" << "\n";
+      continue;
+    }
+    std::cout << std::setw(12) << HumanBytes(static_cast<double>(t.full_scale_cache_bytes))
+              << std::setw(12) << std::setprecision(3) << t.misses_per_op
+              << std::setw(12) << std::setprecision(2) << t.cpu_us_per_op
+              << std::setw(14) << std::setprecision(0) << t.predicted_ops_per_sec << "\n";
+  }
+
+  // With a throughput target, the smallest footprint that meets it wins; otherwise (or if nothing
+  // meets it) the fastest configuration that fits the budget.
+  const TrialResult* best = nullptr;
+  for (const auto& t : trials) {
+    if (!t.fits) {
+      continue;
+    }
+    if (cfg.target_ops > 0 && t.predicted_ops_per_sec >= cfg.target_ops) {
+      if (best == nullptr || best->predicted_ops_per_sec < cfg.target_ops ||
+          t.amplification < best->amplification) {
+        best = &t;
+      }
+    } else if (best == nullptr) {
+      best = &t;
+    }
+  }
+  if (best == nullptr) {
+    std::cout << "\nNo configuration fits in " << HumanBytes(static_cast<double>(cfg.memory_budget)) << "\n";
+    return;
+  }
+  std::cout << "\nRecommended: block_size=" << best->config.block_size << " "
+            << DescribeTrial(best->config) << "\n"
+            << "  amplification " << std::setprecision(2) << best->amplification
+            << ", table reader memory " << HumanBytes(static_cast<double>(best->full_scale_table_mem))
+            << ", block cache " << HumanBytes(static_cast<double>(best->full_scale_cache_bytes))
+            << ", predicted " << std::setprecision(0) << best->predicted_ops_per_sec << " ops/s";
+  if (cfg.target_ops > 0 && best->predicted_ops_per_sec < cfg.target_ops) {
+    std::cout << " (target of " << cfg.target_ops << " ops/s not reachable)";
+  }
+  std::cout << "\n";
+}
+
+// ---------------------------------------------------------------------------------------------
+// Space and index-memory model.
+//
+// Costs each data block entry the way BlockBuilder lays it out (three varints, the non-shared
+// suffix of the internal key, the value), packs entries into blocks with the table builder's
+// flush-by-size policy, and costs one index entry per block using the shortened separator. Key
+// deltas and separators depend on the key distribution, so they are measured on a sample of the
+// dataset's actual keys and the totals are extrapolated.
+
+constexpr uint64_t kModelSampleEntries = 1ull << 20;
+constexpr size_t kInternalKeyFooter = 8;      // Sequence number + value type.
+constexpr size_t kBlockTrailer = 5;           // Compression type + checksum.
+constexpr uint64_t kTableMetaBytes = 4096;    // Properties, metaindex and footer per SST file.
+constexpr uint64_t kTargetFileBytes = 512ull * 1024ull * 1024ull;  // Matches target_file_size_base.
+
+struct ModelPrediction {
+  uint64_t data_blocks = 0;
+  uint64_t data_bytes = 0;
+  uint64_t index_bytes = 0;
+  uint64_t sst_bytes = 0;
+  uint64_t table_readers_mem = 0;
+};
+
+size_t VarintLength(uint64_t v) {
+  size_t len = 1;
+  while (v >= 128) {
+    v >>= 7;
+    ++len;
+  }
+  return len;
+}
+
+// Mirrors BytewiseComparator's FindShortestSeparator: cut after the first differing byte if it can
+// be bumped without reaching `next`, otherwise bump the first later byte of `last` that can be.
+size_t SeparatorLength(const std::string& last, const std::string& next,
+                       rocksdb::BlockBasedTableOptions::IndexShorteningMode mode) {
+  if (mode == rocksdb::BlockBasedTableOptions::IndexShorteningMode::kNoShortening) {
+    return last.size();
+  }
+  const size_t min_len = std::min(last.size(), next.size());
+  size_t diff = 0;
+  while (diff < min_len && last[diff] == next[diff]) {
+    ++diff;
+  }
+  if (diff >= min_len) {
+    return last.size();
+  }
+  const auto last_byte = static_cast<uint8_t>(last[diff]);
+  if (last_byte < 0xff && last_byte + 1 < static_cast<uint8_t>(next[diff])) {
+    return diff + 1;
+  }
+  for (++diff; diff < last.size(); ++diff) {
+    if (static_cast<uint8_t>(last[diff]) < 0xff) {
+      return diff + 1;
+    }
+  }
+  return last.size();
+}
+
+ModelPrediction PredictLayout(const Config& cfg, size_t key_size, size_t value_size, uint64_t entries,
+                              int block_size) {
+  ModelPrediction prediction;
+  if (entries == 0) {
+    return prediction;
+  }
+  const uint64_t sample = std::min(entries, kModelSampleEntries);
+  const size_t block_limit = static_cast<size_t>(block_size);
+  const size_t deviation_limit = block_limit * 90 / 100;  // block_size_deviation = 10.
+  const size_t handle_bytes = VarintLength(kTargetFileBytes / 2) + VarintLength(block_limit);
+
+  double data_bytes = 0.0;
+  double index_bytes = 0.0;
+  uint64_t blocks = 0;
+  size_t buffer = 0;
+  size_t restarts = 0;
+  int since_restart = 0;
+  std::string prev_key;
+  auto entry_bytes = [&](const std::string& key, bool restart) {
+    size_t shared = 0;
+    if (!restart) {
+      while (shared < key.size() && key[shared] == prev_key[shared]) {
+        ++shared;
+      }
+    }
+    const size_t non_shared = key.size() + kInternalKeyFooter - shared;
+    return VarintLength(shared) + VarintLength(non_shared) + VarintLength(value_size) + non_shared +
+           value_size;
+  };
+  for (uint64_t i = 0; i < sample; ++i) {
+    std::string key = TrialKey(i, key_size);
+    bool restart = buffer == 0 || since_restart == cfg.restart_interval;
+    size_t entry = entry_bytes(key, restart);
+    const size_t current = buffer + 4 * restarts + 4;
+    if (buffer > 0 && (current >= block_limit ||
+                       (current + entry + (restart ? 4 : 0) > block_limit && current > deviation_limit))) {
+      data_bytes += static_cast<double>(current) * cfg.compression_ratio + kBlockTrailer;
+      const size_t separator = SeparatorLength(prev_key, key, cfg.index_shortening);
+      index_bytes += 3 + separator + handle_bytes + 4;  // Restart interval 1: every entry restarts.
+      ++blocks;
+      buffer = 0;
+      restarts = 0;
+      restart = true;
+      entry = entry_bytes(key, restart);
+    }
+    if (restart) {
+      ++restarts;
+      since_restart = 0;
+    }
+    buffer += entry;
+    ++since_restart;
+    prev_key = std::move(key);
+  }
+  if (buffer > 0) {
+    data_bytes += static_cast<double>(buffer + 4 * restarts + 4) * cfg.compression_ratio + kBlockTrailer;
+    index_bytes += 3 + key_size + handle_bytes + 4;
+    ++blocks;
+  }
+
+  const double scale = static_cast<double>(entries) / static_cast<double>(sample);
+  prediction.data_blocks = static_cast<uint64_t>(static_cast<double>(blocks) * scale);
+  prediction.data_bytes = static_cast<uint64_t>(data_bytes * scale);
+  prediction.index_bytes = static_cast<uint64_t>(index_bytes * scale);
+  const uint64_t payload = prediction.data_bytes + prediction.index_bytes;
+  const uint64_t files = std::max<uint64_t>(1, (payload + kTargetFileBytes - 1) / kTargetFileBytes);
+  prediction.index_bytes += files * (4 + kBlockTrailer);
+  prediction.sst_bytes = prediction.data_bytes + prediction.index_bytes + files * kTableMetaBytes;
+  // Without cache_index_and_filter_blocks the table readers hold the whole index block (and no
+  // filter is configured), so their memory is the index size.
+  prediction.table_readers_mem = prediction.index_bytes;
+  return prediction;
+}
+
+double ErrorPercent(uint64_t predicted, uint64_t measured) {
+  return measured == 0 ? 0.0
+                       : 100.0 * (static_cast<double>(predicted) - static_cast<double>(measured)) /
+                             static_cast<double>(measured);
+}
+
+void PrintPredictions(const Config& cfg) {
+  const uint64_t entries = cfg.dataset_bytes / (cfg.key_size + cfg.value_size);
+  std::cout << "Predicted layout for " << entries << " entries (" << cfg.key_size << "B keys, "
+            << cfg.value_size << "B values, restart interval " << cfg.restart_interval
+            << ", compression ratio " << std::fixed << std::setprecision(2) << cfg.compression_ratio << ")\n";
+  std::cout << std::left << std::setw(12) << "Block Size"
+            << std::right << std::setw(14) << "Data Blocks"
+            << std::setw(14) << "Data"
+            << std::setw(14) << "Index"
+            << std::setw(14) << "Total SST"
+            << std::setw(12) << "Amplif."
+            << std::setw(14) << "Table Mem" << "\n";
+  const double raw = static_cast<double>(entries * (cfg.key_size + cfg.value_size));
+  for (int block_size : cfg.block_sizes) {
+    ModelPrediction p = PredictLayout(cfg, cfg.key_size, cfg.value_size, entries, block_size);
+    std::cout << std::left << std::setw(12) << HumanBytes(block_size)
+              << std::right << std::setw(14) << p.data_blocks
+              << std::setw(14) << HumanBytes(static_cast<double>(p.data_bytes))
+              << std::setw(14) << HumanBytes(static_cast<double>(p.index_bytes))
+              << std::setw(14) << HumanBytes(static_cast<double>(p.sst_bytes))
+              << std::setw(12) << std::setprecision(2) << static_cast<double>(p.sst_bytes) / raw
+              << std::setw(14) << HumanBytes(static_cast<double>(p.table_readers_mem)) << "\n";
+  }
+}
+
+void PrintModelComparison(const Config& cfg, const std::vector<Result>& results) {
+  std::cout << "\nModel vs measured\n";
+  std::cout << std::left << std::setw(12) << "Block Size"
+            << std::right << std::setw(12) << "Data Pred"
+            << std::setw(12) << "Data Meas"
+            << std::setw(9) << "Err%"
+            << std::setw(12) << "Index Pred"
+            << std::setw(12) << "Index Meas"
+            << std::setw(9) << "Err%"
+            << std::setw(12) << "Mem Pred"
+            << std::setw(12) << "Mem Meas"
+            << std::setw(9) << "Err%" << "\n";
+  for (const auto& r : results) {
+    ModelPrediction p = PredictLayout(cfg, kKeySize, kValueSize, kEntryCount, r.block_size);
+    std::cout << std::left << std::setw(12) << HumanBytes(r.block_size)
+              << std::right << std::setw(12) << HumanBytes(static_cast<double>(p.data_bytes))
+              << std::setw(12) << HumanBytes(static_cast<double>(r.data_bytes))
+              << std::setw(9) << std::fixed << std::setprecision(1) << ErrorPercent(p.data_bytes, r.data_bytes)
+              << std::setw(12) << HumanBytes(static_cast<double>(p.index_bytes))
+              << std::setw(12) << HumanBytes(static_cast<double>(r.index_bytes))
+              << std::setw(9) << ErrorPercent(p.index_bytes, r.index_bytes)
+              << std::setw(12) << HumanBytes(static_cast<double>(p.table_readers_mem))
+              << std::setw(12) << HumanBytes(static_cast<double>(r.table_readers_mem))
+              << std::setw(9) << ErrorPercent(p.table_readers_mem, r.table_readers_mem) << "\n";
+  }
+}
+
+void PrintIngest(const std::vector<Result>& results, const Config& cfg) {
+  std::cout << "\nIngest (" << InsertOrderName(cfg.insert_order) << " order, " << cfg.load_threads
+            << " thread" << (cfg.load_threads == 1 ? "" : "s") << ")\n";
+  std::cout << std::left << std::setw(12) << "Block Size"
+            << std::right << std::setw(12) << "Ingest s"
+            << std::setw(12) << "Write Amp"
+            << "  " << "Layout before full compaction" << "\n";
+  for (const auto& r : results) {
+    std::cout << std::left << std::setw(12) << HumanBytes(r.block_size)
+              << std::right << std::setw(12) << std::fixed << std::setprecision(1) << r.ingest_seconds
+              << std::setw(12) << std::setprecision(2) << r.write_amplification
+              << "  " << r.ingest_layout << "\n";
+  }
+}
+
+void PrintScans(const std::vector<Result>& results) {
+  std::cout << "\nParallel full scan (" << kEntryCount << " rows, "
+            << HumanBytes(static_cast<double>(kScanReadaheadBytes)) << " readahead)\n";
+  std::cout << std::left << std::setw(12) << "Block Size"
+            << std::right << std::setw(10) << "Threads"
+            << std::setw(12) << "Seconds"
+            << std::setw(10) << "GB/s"
+            << std::setw(10) << "Speedup" << "\n";
+  for (const auto& r : results) {
+    for (const auto& scan : r.scans) {
+      std::cout << std::left << std::setw(12) << HumanBytes(r.block_size)
+                << std::right << std::setw(10) << scan.threads
+                << std::setw(12) << std::fixed << std::setprecision(2) << scan.seconds
+                << std::setw(10) << static_cast<double>(scan.bytes) / scan.seconds / 1e9
+                << std::setw(10) << r.scans.front().seconds / scan.seconds << "\n";
+    }
+  }
+}
+
+void PrintDeletes(const std::vector<Result>& results, const Config& cfg) {
+  std::cout << "\nDeletes (" << std::fixed << std::setprecision(1) << 100.0 * cfg.delete_fraction
+            << "% of keys, before -> after full compaction)\n";
+  std::cout << std::left << std::setw(12) << "Block Size"
+            << std::setw(14) << "Kind"
+            << std::right << std::setw(10) << "Delete s"
+            << std::setw(12) << "SST Before"
+            << std::setw(12) << "SST After"
+            << std::setw(12) << "Get us"
+            << std::setw(12) << "-> Get us"
+            << std::setw(12) << "Scan us"
+            << std::setw(12) << "-> Scan us"
+            << std::setw(14) << "Skipped/Scan"
+            << std::setw(12) << "-> Skipped"
+            << std::setw(12) << "Compact s" << "\n";
+  for (const auto& r : results) {
+    for (const auto& d : r.deletes) {
+      std::cout << std::left << std::setw(12) << HumanBytes(r.block_size)
+                << std::setw(14) << DeleteKindName(d.kind)
+                << std::right << std::setw(10) << std::setprecision(1) << d.delete_seconds
+                << std::setw(12) << HumanBytes(static_cast<double>(d.sst_bytes_before))
+                << std::setw(12) << HumanBytes(static_cast<double>(d.sst_bytes_after))
+                << std::setw(12) << std::setprecision(2) << d.get_us_before
+                << std::setw(12) << d.get_us_after
+                << std::setw(12) << std::setprecision(0) << d.scan_us_before
+                << std::setw(12) << d.scan_us_after
+                << std::setw(14) << d.skipped_per_scan_before
+                << std::setw(12) << d.skipped_per_scan_after
+                << std::setw(12) << std::setprecision(1) << d.compaction_seconds << "\n";
+    }
+  }
+}
+
+double PercentChange(double after, double before) {
+  return before == 0.0 ? 0.0 : 100.0 * (after - before) / before;
+}
+
+void PrintUdtComparison(const std::vector<Result>& baseline, const std::vector<Result>& udt) {
+  std::cout << "\nUser-defined timestamps (" << kTimestampSize << "B u64) vs baseline\n";
+  std::cout << std::left << std::setw(12) << "Block Size"
+            << std::right << std::setw(12) << "Amplif."
+            << std::setw(12) << "UDT Amplif."
+            << std::setw(12) << "Index"
+            << std::setw(12) << "UDT Index"
+            << std::setw(10) << "Index +%"
+            << std::setw(12) << "Table Mem"
+            << std::setw(14) << "UDT Table Mem"
+            << std::setw(12) << "Reads/s"
+            << std::setw(14) << "UDT Reads/s" << "\n";
+  for (size_t i = 0; i < baseline.size() && i < udt.size(); ++i) {
+    const Result& b = baseline[i];
+    const Result& u = udt[i];
+    std::cout << std::left << std::setw(12) << HumanBytes(b.block_size)
+              << std::right << std::setw(12) << std::fixed << std::setprecision(2) << b.amplification
+              << std::setw(12) << u.amplification
+              << std::setw(12) << HumanBytes(static_cast<double>(b.index_bytes))
+              << std::setw(12) << HumanBytes(static_cast<double>(u.index_bytes))
+              << std::setw(10) << std::setprecision(1)
+              << PercentChange(static_cast<double>(u.index_bytes), static_cast<double>(b.index_bytes))
+              << std::setw(12) << HumanBytes(static_cast<double>(b.table_readers_mem))
+              << std::setw(14) << HumanBytes(static_cast<double>(u.table_readers_mem))
+              << std::setw(12) << std::setprecision(0) << b.read_ops_per_sec
+              << std::setw(14) << u.read_ops_per_sec << "\n";
+  }
+}
+
+double Fraction(uint64_t part, uint64_t whole) {
+  return whole == 0 ? 0.0 : static_cast<double>(part) / static_cast<double>(whole);
+}
+
+void PrintResidency(const std::vector<Result>& results, uint64_t read_ops) {
+  std::cout << "\nPage cache residency (buffered reads, " << read_ops << " ops)\n";
+  std::cout << std::left << std::setw(12) << "Block Size"
+            << std::right << std::setw(14) << "Before"
+            << std::setw(14) << "After"
+            << std::setw(14) << "Data Res."
+            << std::setw(10) << "Data %"
+            << std::setw(14) << "Idx/Flt Res."
+            << std::setw(12) << "Idx/Flt %"
+            << std::setw(14) << "Bytes/Read" << "\n";
+  for (const auto& r : results) {
+    const ResidencyStats& after = r.residency_after;
+    const uint64_t data_growth = after.data_resident_bytes > r.residency_before.data_resident_bytes
+                                     ? after.data_resident_bytes - r.residency_before.data_resident_bytes
+                                     : 0;
+    std::cout << std::left << std::setw(12) << HumanBytes(r.block_size)
+              << std::right << std::setw(14) << HumanBytes(static_cast<double>(r.residency_before.ResidentBytes()))
+              << std::setw(14) << HumanBytes(static_cast<double>(after.ResidentBytes()))
+              << std::setw(14) << HumanBytes(static_cast<double>(after.data_resident_bytes))
+              << std::setw(10) << std::fixed << std::setprecision(2)
+              << 100.0 * Fraction(after.data_resident_bytes, after.data_bytes)
+              << std::setw(14) << HumanBytes(static_cast<double>(after.meta_resident_bytes))
+              << std::setw(12) << 100.0 * Fraction(after.meta_resident_bytes, after.meta_bytes)
+              << std::setw(14) << std::setprecision(0)
+              << static_cast<double>(data_growth) / static_cast<double>(read_ops) << "\n";
+  }
+}
+
+void PrintWarmup(const std::vector<Result>& results, const Config& cfg) {
+  std::cout << "\nWarm-up after reopen (" << HumanBytes(static_cast<double>(cfg.warmup_cache_bytes))
+            << " block cache, " << kHotKeyCount << " hot keys, " << cfg.read_ops << " ops)\n";
+  std::cout << std::left << std::setw(12) << "Block Size"
+            << std::setw(14) << "Strategy"
+            << std::right << std::setw(12) << "Warm-up s"
+            << std::setw(12) << "Bytes Read"
+            << std::setw(12) << "Cache Fill"
+            << std::setw(12) << "First Hit%"
+            << std::setw(12) << "Steady Hit%"
+            << std::setw(12) << "Steady/s"
+            << std::setw(14) << "To Steady s" << "\n";
+  for (const auto& r : results) {
+    for (const auto& w : r.warmup) {
+      std::cout << std::left << std::setw(12) << HumanBytes(r.block_size)
+                << std::setw(14) << w.strategy
+                << std::right << std::setw(12) << std::fixed << std::setprecision(2) << w.warmup_seconds
+                << std::setw(12) << HumanBytes(static_cast<double>(w.warmup_bytes_read))
+                << std::setw(12) << HumanBytes(static_cast<double>(w.cache_bytes_after_warmup))
+                << std::setw(12) << 100.0 * w.first_window_hit_ratio
+                << std::setw(12) << 100.0 * w.steady_hit_ratio
+                << std::setw(12) << std::setprecision(0) << w.steady_ops_per_sec
+                << std::setw(14) << std::setprecision(2) << w.seconds_to_steady << "\n";
+    }
+  }
+}
+
+// Speedup is relative to the "default" allocator of the same block size, and only reported when
+// both runs were served from the cache.
+void PrintCacheAllocators(const std::vector<Result>& results, const Config& cfg) {
+  std::cout << "\nBlock cache allocator (LRU cache, " << cfg.read_ops << " cached Gets)\n";
+  std::cout << std::left << std::setw(12) << "Block Size"
+            << std::setw(10) << "Allocator"
+            << std::right << std::setw(12) << "Cache"
+            << std::setw(12) << "Reads/s"
+            << std::setw(10) << "Speedup"
+            << std::setw(10) << "Hit%"
+            << std::setw(14) << "dTLB miss/op"
+            << std::setw(12) << "Arena" << "\n";
+  for (const auto& r : results) {
+    const AllocatorStats* baseline = nullptr;
+    for (const auto& a : r.allocators) {
+      if (a.allocator == "default") {
+        baseline = &a;
+      }
+    }
+    for (const auto& a : r.allocators) {
+      const bool comparable = baseline != nullptr && baseline->ops_per_sec > 0.0 &&
+                              baseline->hit_ratio >= kMinCachedHitRatio && a.hit_ratio >= kMinCachedHitRatio;
+      std::cout << std::left << std::setw(12) << HumanBytes(r.block_size)
+                << std::setw(10) << a.allocator
+                << std::right << std::setw(12) << HumanBytes(static_cast<double>(a.cache_bytes))
+                << std::setw(12) << std::fixed << std::setprecision(0) << a.ops_per_sec
+                << std::setprecision(2);
+      if (comparable) {
+        std::cout << std::setw(10) << a.ops_per_sec / baseline->ops_per_sec;
+      } else {
+        std::cout << std::setw(10) << "-";
+      }
+      std::cout << std::setw(10) << 100.0 * a.hit_ratio;
+      if (a.dtlb_misses_per_op >= 0.0) {
+        std::cout << std::setw(14) << a.dtlb_misses_per_op;
+      } else {
+        std::cout << std::setw(14) << "n/a";
+      }
+      std::cout << std::setw(12) << (a.arena_bytes == 0 ? std::string("-") : HumanBytes(a.arena_bytes)) << "\n";
+      if (a.fallback_chunks > 0) {
+        std::cout << "  warning: " << a.fallback_chunks
+                  << " arena chunks fell back to THP after the hugetlbfs pool ran out\n";
+      }
+      if (a.malloc_fallbacks > 0) {
+        std::cout << "  warning: " << a.malloc_fallbacks
+                  << " allocations were served from malloc because the arena could not hold them\n";
+      }
+      if (a.hit_ratio < kMinCachedHitRatio) {
+        std::cout << "  warning: hit ratio below " << 100.0 * kMinCachedHitRatio
+                  << "%, the reads were not served from the cache; raise --block_cache_bytes\n";
+      }
+    }
+  }
+}
+
 }  // namespace
 
 int main(int argc, char** argv) {
   try {
     Config cfg = ParseArguments(argc, argv);
+    if (!cfg.simulate_trace.empty()) {
+      SimulateTraceFile(cfg.simulate_trace, cfg.cache_sizes);
+      return EXIT_SUCCESS;
+    }
+    if (cfg.advise) {
+      RunAdvisor(cfg);
+      return EXIT_SUCCESS;
+    }
+    if (cfg.predict_only) {
+      PrintPredictions(cfg);
+      return EXIT_SUCCESS;
+    }
     std::vector<Result> results;
     results.reserve(cfg.block_sizes.size());
     for (int block_size : cfg.block_sizes) {
@@ -301,24 +2789,69 @@ int main(int argc, char** argv) {
       }
       results.push_back(RunOnce(cfg, block_size));
     }
+    std::vector<Result> udt_results;
+    if (cfg.udt) {
+      // The timestamped pass only feeds the comparison table; the per-mode probes stay on the
+      // baseline run.
+      Config udt_cfg = cfg;
+      udt_cfg.page_cache_residency = false;
+      udt_cfg.cache_trace = false;
+      udt_cfg.warmup = false;
+      udt_cfg.delete_fraction = 0.0;
+      udt_cfg.scan_threads.clear();
+      udt_cfg.cache_allocators.clear();
+      for (int block_size : cfg.block_sizes) {
+        udt_results.push_back(RunOnce(udt_cfg, block_size, /*user_timestamps=*/true));
+      }
+    }
 
     std::cout << "Raw payload bytes: " << kRawPayloadBytes << " ("
               << kEntryCount << " entries)\n";
     std::cout << std::left << std::setw(12) << "Block Size"
               << std::right << std::setw(16) << "Total SST"
+              << std::setw(12) << "Pred. SST"
               << std::setw(12) << "Amplif."
               << std::setw(18) << "Est. Keys"
               << std::setw(14) << "Table Mem"
+              << std::setw(12) << "Pred. Mem"
               << std::setw(12) << "Reads/s" << "\n";
     for (const auto& r : results) {
+      ModelPrediction predicted = PredictLayout(cfg, kKeySize, kValueSize, kEntryCount, r.block_size);
       std::cout << std::left << std::setw(12) << HumanBytes(r.block_size)
                 << std::right << std::setw(16) << HumanBytes(static_cast<double>(r.total_sst_bytes))
+                << std::setw(12) << HumanBytes(static_cast<double>(predicted.sst_bytes))
                 << std::setw(12) << std::fixed << std::setprecision(2) << r.amplification
                 << std::setw(18) << r.estimated_keys
                 << std::setw(14) << HumanBytes(static_cast<double>(r.table_readers_mem))
+                << std::setw(12) << HumanBytes(static_cast<double>(predicted.table_readers_mem))
                 << std::setw(12) << std::setprecision(0) << std::fixed << r.read_ops_per_sec
                 << "\n";
     }
+    PrintModelComparison(cfg, results);
+    PrintIngest(results, cfg);
+    if (!cfg.scan_threads.empty()) {
+      PrintScans(results);
+    }
+    if (cfg.delete_fraction > 0.0) {
+      PrintDeletes(results, cfg);
+    }
+    if (cfg.udt) {
+      PrintUdtComparison(results, udt_results);
+    }
+    if (cfg.page_cache_residency && cfg.read_ops > 0) {
+      PrintResidency(results, cfg.read_ops);
+    }
+    if (cfg.warmup && cfg.read_ops > 0) {
+      PrintWarmup(results, cfg);
+    }
+    if (!cfg.cache_allocators.empty() && cfg.read_ops > 0) {
+      PrintCacheAllocators(results, cfg);
+    }
+    if (cfg.cache_trace && cfg.read_ops > 0) {
+      for (const auto& r : results) {
+        SimulateTraceFile(r.cache_trace_path, cfg.cache_sizes);
+      }
+    }
   } catch (const std::exception& ex) {
     std::cerr << "Error: " << ex.what() << "\n";
     return EXIT_FAILURE;
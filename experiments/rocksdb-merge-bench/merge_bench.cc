@@ -1,31 +1,115 @@
 #include <algorithm>
+#include <array>
 #include <atomic>
+#include <cctype>
 #include <chrono>
 #include <cmath>
 #include <cstdint>
 #include <cstring>
+#include <ctime>
+#include <exception>
 #include <filesystem>
 #include <iomanip>
 #include <iostream>
+#include <limits>
 #include <memory>
+#include <mutex>
 #include <random>
+#include <set>
 #include <stdexcept>
 #include <string>
 #include <thread>
 #include <vector>
 
 #include <rocksdb/db.h>
+#include <rocksdb/env.h>
+#include <rocksdb/memtablerep.h>
 #include <rocksdb/merge_operator.h>
 #include <rocksdb/options.h>
+#include <rocksdb/perf_context.h>
+#include <rocksdb/perf_level.h>
+#include <rocksdb/slice_transform.h>
+#include <rocksdb/sst_file_writer.h>
+#include <rocksdb/statistics.h>
+#include <rocksdb/utilities/checkpoint.h>
+#include <rocksdb/utilities/optimistic_transaction_db.h>
+#include <rocksdb/utilities/transaction_db.h>
+#include <rocksdb/write_batch.h>
 
 namespace {
 
+// kRmw is the unsynchronized Get + Put and loses concurrent increments; the other RMW strategies
+// serialize each increment so their counters are exact. kCombined buffers deltas per thread and
+// writes them as Merge operands.
+enum class Strategy { kRmw, kStriped, kTransaction, kOptimistic, kMerge, kCombined };
+
+// One point of the WAL / write-pipeline sweep. Each field is a toggle away from RocksDB's defaults.
+struct WritePipeline {
+  std::string name = "default";
+  bool disable_wal = false;
+  bool sync = false;
+  bool manual_wal_flush = false;  // WAL writes are buffered and flushed by a periodic FlushWAL.
+  bool pipelined = false;
+  bool unordered = false;
+  bool two_write_queues = false;
+  bool concurrent_memtable = true;
+};
+
+// One point of the memtable sweep: the representation plus the optional prefix bloom and in-place
+// update toggles.
+struct MemtableConfig {
+  std::string name = "skiplist";
+  std::string rep = "skiplist";  // skiplist, hash_skiplist, hash_linklist or vector.
+  bool prefix_bloom = false;
+  bool inplace_update = false;
+};
+
+// How workers pick keys. Zipf ranks are key indices, so key 0 is the hottest.
+struct KeyDistribution {
+  enum class Kind { kUniform, kZipf, kHotspot };
+  std::string name = "uniform";
+  Kind kind = Kind::kUniform;
+  double theta = 0.0;            // kZipf, in (0, 1).
+  double hot_fraction = 0.0;     // kHotspot: share of the key space that is hot, in (0, 1).
+  double hot_probability = 0.0;  // kHotspot: probability an operation goes to the hot keys.
+};
+
+// One point of the write-time collapsing sweep. With max_successive_merges = N, a Merge that finds
+// N operands for its key in the memtable folds them into a value first; strict also does so when
+// that means reading the key's base value from SST files.
+struct MergeCollapse {
+  std::string name = "0";
+  size_t max_successive_merges = 0;
+  bool strict = false;
+};
+
 struct Config {
   std::filesystem::path db_root = std::filesystem::path{"./merge_bench_runs"};
   uint64_t key_space = 10'000;
-  int threads = 8;
+  std::vector<int> thread_counts = {8};
+  std::vector<size_t> write_batch_sizes = {1};
+  std::vector<WritePipeline> write_pipelines = {WritePipeline{}};
+  int wal_flush_ms = 10;
+  std::vector<MemtableConfig> memtables = {MemtableConfig{}};
+  std::vector<KeyDistribution> key_dists = {KeyDistribution{}};
+  std::vector<MergeCollapse> merge_collapses = {MergeCollapse{}};
+  std::vector<uint64_t> depths;  // Non-empty selects the operand-depth sweep instead of the mixes.
+  std::vector<std::string> depth_placements = {"memtable", "l0", "levels"};
+  uint64_t depth_keys = 1'000;
   int seconds_per_phase = 15;
+  int warmup_seconds = 2;
   std::string mix_filter;
+  bool null_engine = false;
+  bool steady_state = false;
+  bool time_reads = false;  // Derived from the other flags; see ParseArguments.
+  bool merge_stats = false;
+  bool deferred_cost = false;
+  std::string prepopulate = "sst";
+  int prepopulate_threads = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+  std::vector<Strategy> strategies = {Strategy::kRmw,   Strategy::kStriped, Strategy::kTransaction,
+                                      Strategy::kOptimistic, Strategy::kMerge, Strategy::kCombined};
+  size_t combine_keys = 1024;
+  int combine_ms = 10;
 };
 
 struct Workload {
@@ -33,16 +117,377 @@ struct Workload {
   double read_ratio;  // Between 0 and 1.
 };
 
+// Log-linear latency histogram: 32 linear sub-buckets per power of two of nanoseconds, so any
+// reported percentile is within about 3% of the exact value. Recording is a shift and an add.
+// The buckets work for any unsigned count, which the verification scan uses for updates per key.
+class LatencyHistogram {
+ public:
+  void Record(uint64_t ns) {
+    ++counts_[BucketOf(ns)];
+    ++total_;
+  }
+
+  void Merge(const LatencyHistogram& other) {
+    for (size_t b = 0; b < kBuckets; ++b) {
+      counts_[b] += other.counts_[b];
+    }
+    total_ += other.total_;
+  }
+
+  uint64_t Count() const { return total_; }
+
+  double PercentileUs(double percentile) const { return Percentile(percentile) / 1000.0; }
+
+  // In the recorded unit. Values below 32 have their own bucket and come back exact.
+  double Percentile(double percentile) const {
+    if (total_ == 0) {
+      return 0.0;
+    }
+    const auto rank = static_cast<uint64_t>(std::ceil(percentile / 100.0 * static_cast<double>(total_)));
+    uint64_t seen = 0;
+    for (size_t b = 0; b < kBuckets; ++b) {
+      seen += counts_[b];
+      if (seen >= std::max<uint64_t>(1, rank)) {
+        return BucketMidpointNs(b);
+      }
+    }
+    return BucketMidpointNs(kBuckets - 1);
+  }
+
+ private:
+  static constexpr int kSubBucketBits = 5;
+  static constexpr size_t kSubBuckets = size_t{1} << kSubBucketBits;
+  static constexpr size_t kBuckets = (64 - kSubBucketBits + 1) * kSubBuckets;
+
+  static size_t BucketOf(uint64_t ns) {
+    if (ns < kSubBuckets) {
+      return static_cast<size_t>(ns);
+    }
+    const int shift = 63 - __builtin_clzll(ns) - kSubBucketBits;
+    return static_cast<size_t>(shift + 1) * kSubBuckets + static_cast<size_t>((ns >> shift) & (kSubBuckets - 1));
+  }
+
+  static double BucketMidpointNs(size_t bucket) {
+    if (bucket < kSubBuckets) {
+      return static_cast<double>(bucket);
+    }
+    const int shift = static_cast<int>(bucket / kSubBuckets) - 1;
+    const double lower = std::ldexp(static_cast<double>(kSubBuckets + bucket % kSubBuckets), shift);
+    return lower + std::ldexp(0.5, shift);
+  }
+
+  std::array<uint64_t, kBuckets> counts_{};
+  uint64_t total_ = 0;
+};
+
+// One second of a mix. Rates and latency cover the interval; operands per key count everything
+// written so far, warm-up included; the LSM figures are read at the end of the interval.
+struct IntervalSample {
+  double seconds = 0.0;  // End of the interval, from the start of the measured window.
+  double merge_ops_per_key = 0.0;
+  double read_ops_per_sec = 0.0;
+  double write_ops_per_sec = 0.0;
+  double avg_get_us = -1.0;  // Negative when reads are not timed.
+  uint64_t l0_files = 0;
+  uint64_t pending_compaction_bytes = 0;
+  double stall_ms = 0.0;  // STALL_MICROS accumulated over the interval.
+};
+
+// One flush plus full-range compaction: wall time, process CPU time and bytes written.
+struct CompactionCost {
+  double seconds = 0.0;
+  double cpu_seconds = 0.0;
+  uint64_t bytes_written = 0;
+};
+
 struct Metrics {
+  std::string mix;
+  int threads = 0;
+  size_t batch_size = 1;
+  std::string pipeline;
+  std::string memtable;
+  std::string key_dist;
+  std::string collapse;
+  bool merge_stats = false;  // Whether the read-side merge figures below were collected.
   double read_ops_per_sec = 0.0;
   double write_ops_per_sec = 0.0;
   double avg_merge_ops_per_key = 0.0;
+  double restore_seconds = 0.0;
+  double retry_rate = 0.0;  // Retried attempts per measured increment.
+  int64_t lost_updates = 0;
+  double avg_staleness_ms = 0.0;  // Strategy::kCombined: increment to flush, averaged per increment.
+  double max_staleness_ms = 0.0;
+  double write_us_per_update = 0.0;  // Time applying writes divided by the updates they carried.
+  double p99_write_us = 0.0;         // Per write call, or per batch when batching.
+  double cpu_us_per_op = 0.0;        // Worker thread CPU time over the measured window, per operation.
+  double worker_cpu_seconds = 0.0;   // The same CPU time in total, and the increments it covered.
+  uint64_t measured_increments = 0;
+  uint64_t total_increments = 0;  // Every increment the mix applied, warm-up included.
+  double background_compaction_cpu_seconds = 0.0;  // COMPACTION_CPU_TOTAL_TIME during the window.
+  CompactionCost compact;  // The flush and full compaction run after the mix under --deferred_cost.
+  // Read-side merge work over the measured window, from the workers' PerfContext and the DB's
+  // Statistics. Point lookups include the RMW strategies' own reads.
+  uint64_t lookup_merge_operands = 0;  // PerfContext::internal_merge_point_lookup_count.
+  uint64_t iterator_merge_operands = 0;  // PerfContext::internal_merge_count.
+  uint64_t merge_time_ns = 0;  // MERGE_OPERATION_TOTAL_TIME.
+  rocksdb::HistogramData operands_per_get{};  // READ_NUM_MERGE_OPERANDS.
+  std::vector<IntervalSample> series;
+  LatencyHistogram hot_read_latency;  // Gets on the distribution's hot keys, and on all the others.
+  LatencyHistogram cold_read_latency;
+  uint64_t max_increments_per_key = 0;  // From the verification scan; see CounterScan.
+  uint64_t p99_increments_per_key = 0;
+  std::vector<std::pair<std::string, uint64_t>> top_keys;
 };
 
 const std::vector<Workload> kWorkloads = {
     {"10/90", 0.10}, {"50/50", 0.50}, {"90/10", 0.90},
 };
 
+const char* StrategyName(Strategy strategy) {
+  switch (strategy) {
+    case Strategy::kRmw:
+      return "rmw";
+    case Strategy::kStriped:
+      return "striped";
+    case Strategy::kTransaction:
+      return "txn";
+    case Strategy::kOptimistic:
+      return "optimistic";
+    case Strategy::kMerge:
+      return "merge";
+    case Strategy::kCombined:
+      return "combined";
+  }
+  return "unknown";
+}
+
+const char* StrategyTitle(Strategy strategy) {
+  switch (strategy) {
+    case Strategy::kRmw:
+      return "Read-Modify-Write (unsynchronized)";
+    case Strategy::kStriped:
+      return "Read-Modify-Write (striped mutexes)";
+    case Strategy::kTransaction:
+      return "Read-Modify-Write (TransactionDB)";
+    case Strategy::kOptimistic:
+      return "Read-Modify-Write (OptimisticTransactionDB)";
+    case Strategy::kMerge:
+      return "Merge";
+    case Strategy::kCombined:
+      return "Merge (write-combined)";
+  }
+  return "unknown";
+}
+
+// Splits a comma-separated flag value into its entries, trimming whitespace around each one and
+// dropping empty ones.
+std::vector<std::string> SplitCsv(const std::string& csv) {
+  std::vector<std::string> entries;
+  size_t begin = 0;
+  while (begin <= csv.size()) {
+    size_t end = std::min(csv.find(',', begin), csv.size());
+    const size_t next = end + 1;
+    while (begin < end && std::isspace(static_cast<unsigned char>(csv[begin]))) {
+      ++begin;
+    }
+    while (end > begin && std::isspace(static_cast<unsigned char>(csv[end - 1]))) {
+      --end;
+    }
+    if (end > begin) {
+      entries.push_back(csv.substr(begin, end - begin));
+    }
+    begin = next;
+  }
+  return entries;
+}
+
+std::vector<Strategy> ParseStrategies(const std::string& csv) {
+  std::vector<Strategy> strategies;
+  for (const std::string& entry : SplitCsv(csv)) {
+    if (entry == "rmw") {
+      strategies.push_back(Strategy::kRmw);
+    } else if (entry == "striped") {
+      strategies.push_back(Strategy::kStriped);
+    } else if (entry == "txn") {
+      strategies.push_back(Strategy::kTransaction);
+    } else if (entry == "optimistic") {
+      strategies.push_back(Strategy::kOptimistic);
+    } else if (entry == "merge") {
+      strategies.push_back(Strategy::kMerge);
+    } else if (entry == "combined") {
+      strategies.push_back(Strategy::kCombined);
+    } else {
+      throw std::runtime_error("Unknown strategy: " + entry);
+    }
+  }
+  if (strategies.empty()) {
+    throw std::runtime_error("--strategies must name at least one strategy");
+  }
+  return strategies;
+}
+
+// Each comma-separated entry combines '+'-separated toggles, e.g. "default,no_wal,sync,pipelined+sync".
+std::vector<WritePipeline> ParseWritePipelines(const std::string& csv) {
+  std::vector<WritePipeline> pipelines;
+  for (const std::string& entry : SplitCsv(csv)) {
+    WritePipeline pipeline;
+    pipeline.name = entry;
+    size_t begin = 0;
+    while (begin <= entry.size()) {
+      const size_t end = std::min(entry.find('+', begin), entry.size());
+      const std::string toggle = entry.substr(begin, end - begin);
+      if (toggle == "no_wal") {
+        pipeline.disable_wal = true;
+      } else if (toggle == "sync") {
+        pipeline.sync = true;
+      } else if (toggle == "manual_flush") {
+        pipeline.manual_wal_flush = true;
+      } else if (toggle == "pipelined") {
+        pipeline.pipelined = true;
+      } else if (toggle == "unordered") {
+        pipeline.unordered = true;
+      } else if (toggle == "two_queues") {
+        pipeline.two_write_queues = true;
+      } else if (toggle == "serial_memtable") {
+        pipeline.concurrent_memtable = false;
+      } else if (toggle != "default") {
+        throw std::runtime_error("Unknown write pipeline toggle: " + toggle);
+      }
+      begin = end + 1;
+    }
+    pipelines.push_back(pipeline);
+  }
+  if (pipelines.empty()) {
+    throw std::runtime_error("--write_pipeline needs at least one entry");
+  }
+  return pipelines;
+}
+
+// Each comma-separated entry is a representation optionally followed by "+bloom" and/or
+// "+inplace", e.g. "skiplist,hash_skiplist,skiplist+bloom,skiplist+inplace".
+std::vector<MemtableConfig> ParseMemtables(const std::string& csv) {
+  std::vector<MemtableConfig> memtables;
+  for (const std::string& entry : SplitCsv(csv)) {
+    MemtableConfig memtable;
+    memtable.name = entry;
+    bool has_rep = false;
+    size_t begin = 0;
+    while (begin <= entry.size()) {
+      const size_t end = std::min(entry.find('+', begin), entry.size());
+      const std::string toggle = entry.substr(begin, end - begin);
+      if (toggle == "skiplist" || toggle == "hash_skiplist" || toggle == "hash_linklist" || toggle == "vector") {
+        if (has_rep) {
+          throw std::runtime_error("--memtable entry names two representations: " + entry);
+        }
+        memtable.rep = toggle;
+        has_rep = true;
+      } else if (toggle == "bloom") {
+        memtable.prefix_bloom = true;
+      } else if (toggle == "inplace") {
+        memtable.inplace_update = true;
+      } else {
+        throw std::runtime_error("Unknown memtable toggle: " + toggle);
+      }
+      begin = end + 1;
+    }
+    memtables.push_back(memtable);
+  }
+  if (memtables.empty()) {
+    throw std::runtime_error("--memtable needs at least one entry");
+  }
+  return memtables;
+}
+
+// Comma-separated entries: "uniform", "zipf:<theta>" or "hotspot:<hot fraction>:<hot probability>".
+std::vector<KeyDistribution> ParseKeyDistributions(const std::string& csv) {
+  std::vector<KeyDistribution> dists;
+  for (const std::string& entry : SplitCsv(csv)) {
+    KeyDistribution dist;
+    dist.name = entry;
+    std::vector<std::string> parts;
+    size_t begin = 0;
+    while (begin <= entry.size()) {
+      const size_t end = std::min(entry.find(':', begin), entry.size());
+      parts.push_back(entry.substr(begin, end - begin));
+      begin = end + 1;
+    }
+    if (parts[0] == "uniform" && parts.size() == 1) {
+      dist.kind = KeyDistribution::Kind::kUniform;
+    } else if (parts[0] == "zipf" && parts.size() == 2) {
+      dist.kind = KeyDistribution::Kind::kZipf;
+      dist.theta = std::stod(parts[1]);
+      if (dist.theta <= 0.0 || dist.theta >= 1.0) {
+        throw std::runtime_error("zipf theta must be in (0, 1): " + entry);
+      }
+    } else if (parts[0] == "hotspot" && parts.size() == 3) {
+      dist.kind = KeyDistribution::Kind::kHotspot;
+      dist.hot_fraction = std::stod(parts[1]);
+      dist.hot_probability = std::stod(parts[2]);
+      if (dist.hot_fraction <= 0.0 || dist.hot_fraction >= 1.0 || dist.hot_probability < 0.0 ||
+          dist.hot_probability > 1.0) {
+        throw std::runtime_error("hotspot needs a fraction in (0, 1) and a probability in [0, 1]: " + entry);
+      }
+    } else {
+      throw std::runtime_error("Unknown key distribution: " + entry);
+    }
+    dists.push_back(dist);
+  }
+  if (dists.empty()) {
+    throw std::runtime_error("--key_dist needs at least one entry");
+  }
+  return dists;
+}
+
+// The key skew table and hot/cold Get timing only mean something once a skewed distribution runs.
+bool HasSkewedKeyDistribution(const Config& cfg) {
+  return std::any_of(cfg.key_dists.begin(), cfg.key_dists.end(), [](const KeyDistribution& dist) {
+    return dist.kind != KeyDistribution::Kind::kUniform;
+  });
+}
+
+// Comma-separated entries: N, or N:strict for strict_max_successive_merges. 0 disables collapsing.
+std::vector<MergeCollapse> ParseMergeCollapses(const std::string& csv) {
+  std::vector<MergeCollapse> collapses;
+  for (const std::string& entry : SplitCsv(csv)) {
+    MergeCollapse collapse;
+    collapse.name = entry;
+    const size_t colon = entry.find(':');
+    const std::string count = entry.substr(0, colon);
+    if (colon != std::string::npos) {
+      if (entry.substr(colon + 1) != "strict") {
+        throw std::runtime_error("Unknown max_successive_merges suffix: " + entry);
+      }
+      collapse.strict = true;
+    }
+    if (count.empty() || count.find_first_not_of("0123456789") != std::string::npos) {
+      throw std::runtime_error("--max_successive_merges values must be non-negative integers: " + entry);
+    }
+    collapse.max_successive_merges = std::stoull(count);
+    collapses.push_back(collapse);
+  }
+  if (collapses.empty()) {
+    throw std::runtime_error("--max_successive_merges needs at least one entry");
+  }
+  return collapses;
+}
+
+// Parses a comma-separated list of positive counts, e.g. "1,8,32".
+template <typename T>
+std::vector<T> ParseCounts(const std::string& csv, const std::string& flag) {
+  std::vector<T> values;
+  for (const std::string& entry : SplitCsv(csv)) {
+    const long long value = std::stoll(entry);
+    if (value <= 0) {
+      throw std::runtime_error(flag + " values must be positive: " + entry);
+    }
+    values.push_back(static_cast<T>(value));
+  }
+  if (values.empty()) {
+    throw std::runtime_error(flag + " needs at least one value");
+  }
+  return values;
+}
+
 std::vector<Workload> SelectWorkloads(const std::string& filter) {
   if (filter.empty()) {
     return kWorkloads;
@@ -71,6 +516,171 @@ std::string Encode(uint64_t value) {
   return out;
 }
 
+// Keys are decimal strings zero-padded to the width of the largest key, so byte order matches
+// numeric order and Prepopulate can split the key space into sorted ranges. Up to
+// kMaxKeyTableKeys of them are formatted once into a flat table shared by all workers; larger key
+// spaces format into a per-thread buffer. Either way the hot loop does not allocate.
+constexpr uint64_t kMaxKeyTableKeys = 16ull * 1024ull * 1024ull;
+using KeyBuffer = std::array<char, 20>;
+
+class KeyTable {
+ public:
+  explicit KeyTable(uint64_t key_space) {
+    for (uint64_t largest = key_space > 0 ? key_space - 1 : 0; largest >= 10; largest /= 10) {
+      ++width_;
+    }
+    if (key_space > kMaxKeyTableKeys) {
+      return;
+    }
+    bytes_.resize(key_space * width_);
+    for (uint64_t i = 0; i < key_space; ++i) {
+      Format(i, bytes_.data() + i * width_);
+    }
+  }
+
+  rocksdb::Slice Key(uint64_t index, KeyBuffer* scratch) const {
+    if (bytes_.empty()) {
+      Format(index, scratch->data());
+      return rocksdb::Slice(scratch->data(), width_);
+    }
+    return rocksdb::Slice(bytes_.data() + index * width_, width_);
+  }
+
+  size_t width() const { return width_; }
+
+ private:
+  void Format(uint64_t index, char* out) const {
+    for (size_t i = width_; i > 0; --i) {
+      out[i - 1] = static_cast<char>('0' + index % 10);
+      index /= 10;
+    }
+  }
+
+  size_t width_ = 1;
+  std::vector<char> bytes_;
+};
+
+// SplitMix64: one add and three multiply/xor-shift rounds per draw, far cheaper than mt19937_64
+// plus a distribution object.
+class FastRng {
+ public:
+  explicit FastRng(uint64_t seed) : state_(seed) {}
+
+  uint64_t Next() {
+    uint64_t z = (state_ += 0x9E3779B97F4A7C15ull);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+  }
+
+  // Uniform in [0, n) by multiply-shift, without a division.
+  uint64_t Uniform(uint64_t n) { return static_cast<uint64_t>((static_cast<unsigned __int128>(Next()) * n) >> 64); }
+
+ private:
+  uint64_t state_;
+};
+
+// Maps a probability onto the full uint64_t range so that `rng.Next() < threshold` is a single
+// comparison.
+uint64_t ProbabilityThreshold(double probability) {
+  if (probability <= 0.0) {
+    return 0;
+  }
+  if (probability >= 1.0) {
+    return std::numeric_limits<uint64_t>::max();
+  }
+  return static_cast<uint64_t>(std::ldexp(probability, 64));
+}
+
+// Draws key indices for one KeyDistribution. Zipf uses the Gray et al. generator YCSB uses: zeta(n)
+// is summed once here, after which a draw is one pow(). The hot set used to split read latency is
+// the hotspot's hot keys, or the lowest 1% of indices (the top Zipf ranks) for the other kinds.
+class KeySampler {
+ public:
+  KeySampler(const KeyDistribution& dist, uint64_t key_space) : dist_(dist), key_space_(key_space) {
+    if (dist.kind == KeyDistribution::Kind::kHotspot) {
+      if (key_space < 2) {
+        throw std::runtime_error("A hotspot distribution needs at least two keys");
+      }
+      hot_keys_ = std::clamp<uint64_t>(static_cast<uint64_t>(dist.hot_fraction * static_cast<double>(key_space)), 1,
+                                       key_space - 1);
+      hot_threshold_ = ProbabilityThreshold(dist.hot_probability);
+    } else {
+      hot_keys_ = std::max<uint64_t>(1, (key_space + 99) / 100);
+    }
+    if (dist.kind == KeyDistribution::Kind::kZipf) {
+      zeta_n_ = Zeta(key_space, dist.theta);
+      const double zeta_2 = 1.0 + std::pow(0.5, dist.theta);
+      alpha_ = 1.0 / (1.0 - dist.theta);
+      eta_ = (1.0 - std::pow(2.0 / static_cast<double>(key_space), 1.0 - dist.theta)) / (1.0 - zeta_2 / zeta_n_);
+      half_pow_theta_ = std::pow(0.5, dist.theta);
+    }
+  }
+
+  uint64_t Next(FastRng& rng) const {
+    switch (dist_.kind) {
+      case KeyDistribution::Kind::kUniform:
+        break;
+      case KeyDistribution::Kind::kZipf: {
+        const double u = std::ldexp(static_cast<double>(rng.Next() >> 11), -53);
+        const double uz = u * zeta_n_;
+        if (uz < 1.0) {
+          return 0;
+        }
+        if (uz < 1.0 + half_pow_theta_) {
+          return std::min<uint64_t>(1, key_space_ - 1);
+        }
+        const auto rank =
+            static_cast<uint64_t>(static_cast<double>(key_space_) * std::pow(eta_ * u - eta_ + 1.0, alpha_));
+        return std::min(rank, key_space_ - 1);
+      }
+      case KeyDistribution::Kind::kHotspot:
+        if (rng.Next() < hot_threshold_) {
+          return rng.Uniform(hot_keys_);
+        }
+        return hot_keys_ + rng.Uniform(key_space_ - hot_keys_);
+    }
+    return rng.Uniform(key_space_);
+  }
+
+  bool IsHot(uint64_t index) const { return index < hot_keys_; }
+  const std::string& name() const { return dist_.name; }
+
+ private:
+  static constexpr uint64_t kZetaExactTerms = 1'000;
+
+  // The generalized harmonic number sum(i^-theta, i = 1..n). The first kZetaExactTerms terms are
+  // summed; the tail uses the Euler-Maclaurin integral approximation, whose error is far below
+  // double precision once the terms vary this slowly. Construction is O(1) in the key space.
+  static double Zeta(uint64_t n, double theta) {
+    const uint64_t exact = std::min(n, kZetaExactTerms);
+    double sum = 0.0;
+    for (uint64_t i = 1; i <= exact; ++i) {
+      sum += std::pow(static_cast<double>(i), -theta);
+    }
+    if (n == exact) {
+      return sum;
+    }
+    const double k = static_cast<double>(exact);
+    const double m = static_cast<double>(n);
+    auto f = [theta](double x) { return std::pow(x, -theta); };
+    auto df = [theta](double x) { return -theta * std::pow(x, -theta - 1.0); };
+    sum += (std::pow(m, 1.0 - theta) - std::pow(k, 1.0 - theta)) / (1.0 - theta);
+    sum += (f(m) - f(k)) / 2.0;
+    sum += (df(m) - df(k)) / 12.0;
+    return sum;
+  }
+
+  KeyDistribution dist_;
+  uint64_t key_space_;
+  uint64_t hot_keys_ = 1;
+  uint64_t hot_threshold_ = 0;
+  double zeta_n_ = 0.0;
+  double alpha_ = 0.0;
+  double eta_ = 0.0;
+  double half_pow_theta_ = 0.0;
+};
+
 class CountMergeOperator : public rocksdb::MergeOperator {
  public:
   bool FullMergeV2(const MergeOperationInput& merge_in,
@@ -100,7 +710,11 @@ class CountMergeOperator : public rocksdb::MergeOperator {
   const char* Name() const override { return "CountMergeOperator"; }
 };
 
-rocksdb::Options BuildOptions(bool use_merge) {
+// The default setup keeps every operand in one 512 MB memtable with compactions off, which isolates
+// the read cost of deep merge chains. --steady_state instead uses a 64 MB write buffer and leaves
+// flushes and level compaction running, so reads see what a live DB would: operands spread over
+// memtables, a varying number of L0 files, and levels being compacted underneath them.
+rocksdb::Options BuildOptions(bool use_merge, bool steady_state) {
   rocksdb::Options options;
   options.create_if_missing = true;
   options.error_if_exists = true;
@@ -116,141 +730,1576 @@ rocksdb::Options BuildOptions(bool use_merge) {
   options.target_file_size_base = 512ull * 1024ull * 1024ull;
   options.max_background_flushes = 2;
   options.disable_auto_compactions = true;
+  if (steady_state) {
+    options.write_buffer_size = 64ull * 1024ull * 1024ull;
+    options.target_file_size_base = 64ull * 1024ull * 1024ull;
+    options.disable_auto_compactions = false;
+  }
   options.use_direct_reads = true;
   options.use_direct_io_for_flush_and_compaction = true;
   options.compaction_readahead_size = 2 * 1024 * 1024;
   return options;
 }
 
-void Prepopulate(rocksdb::DB* db, uint64_t key_space) {
+// The hash representations bucket by prefix, so they get a prefix extractor covering the whole
+// fixed-width key: each counter then has its own bucket and a Get only walks that counter's
+// entries. Only the skiplist takes concurrent inserts, and in-place updates need the write lock, so
+// every other variant falls back to allow_concurrent_memtable_write=false.
+constexpr size_t kMaxMemtableBuckets = 1 << 20;
+
+void ApplyMemtable(const MemtableConfig& memtable, size_t key_width, uint64_t key_space, rocksdb::Options* options) {
+  const size_t buckets = static_cast<size_t>(std::min<uint64_t>(std::max<uint64_t>(key_space, 1), kMaxMemtableBuckets));
+  if (memtable.rep == "hash_skiplist") {
+    options->memtable_factory.reset(rocksdb::NewHashSkipListRepFactory(buckets));
+  } else if (memtable.rep == "hash_linklist") {
+    options->memtable_factory.reset(rocksdb::NewHashLinkListRepFactory(buckets));
+  } else if (memtable.rep == "vector") {
+    options->memtable_factory = std::make_shared<rocksdb::VectorRepFactory>();
+  } else {
+    options->memtable_factory = std::make_shared<rocksdb::SkipListFactory>();
+  }
+  if (memtable.rep == "hash_skiplist" || memtable.rep == "hash_linklist") {
+    options->prefix_extractor.reset(rocksdb::NewCappedPrefixTransform(key_width));
+  }
+  if (memtable.prefix_bloom) {
+    options->memtable_prefix_bloom_size_ratio = 0.1;
+    options->memtable_whole_key_filtering = true;
+  }
+  options->inplace_update_support = memtable.inplace_update;
+  options->allow_concurrent_memtable_write = memtable.rep == "skiplist" && !memtable.inplace_update;
+}
+
+// A copy of `options` with a fresh Statistics object, so each opened DB counts only its own run.
+// Tickers alone cover stalls, flushes and compactions. With merge_stats the level also records
+// histograms and MERGE_OPERATION_TOTAL_TIME, a detailed timer that costs a clock read per merge.
+rocksdb::Options WithStatistics(const rocksdb::Options& options, bool merge_stats) {
+  rocksdb::Options copy = options;
+  copy.statistics = rocksdb::CreateDBStatistics();
+  copy.statistics->set_stats_level(merge_stats ? rocksdb::StatsLevel::kExceptTimeForMutex
+                                               : rocksdb::StatsLevel::kExceptHistogramOrTimers);
+  return copy;
+}
+
+// Prepopulation splits the key space into one contiguous, sorted range per thread. The bulk path
+// writes each range into its own SST file with SstFileWriter and ingests them all at once; since
+// the ranges do not overlap, the files go straight to the bottommost level. The batch path, and
+// the fallback when SST building or ingestion fails, writes kPrepopulateBatchKeys Puts per
+// WriteBatch without the WAL.
+constexpr uint64_t kPrepopulateBatchKeys = 100'000;
+
+template <typename Fn>
+void ForEachKeyRange(uint64_t key_space, int threads, Fn&& fn) {
+  const uint64_t ranges = std::max<uint64_t>(1, std::min<uint64_t>(threads, key_space));
+  std::vector<std::thread> workers;
+  std::vector<std::exception_ptr> errors(ranges);
+  for (uint64_t r = 0; r < ranges; ++r) {
+    workers.emplace_back([&, r]() {
+      try {
+        fn(r, key_space * r / ranges, key_space * (r + 1) / ranges);
+      } catch (...) {
+        errors[r] = std::current_exception();
+      }
+    });
+  }
+  for (auto& worker : workers) {
+    worker.join();
+  }
+  for (const auto& error : errors) {
+    if (error) {
+      std::rethrow_exception(error);
+    }
+  }
+}
+
+void PrepopulateWithBatches(rocksdb::DB* db, const KeyTable& keys, uint64_t key_space, int threads) {
   rocksdb::WriteOptions write_options;
   write_options.disableWAL = true;
-  for (uint64_t i = 0; i < key_space; ++i) {
-    auto status = db->Put(write_options, std::to_string(i), Encode(0));
+  const std::string zero = Encode(0);
+  ForEachKeyRange(key_space, threads, [&](uint64_t, uint64_t begin, uint64_t end) {
+    KeyBuffer scratch{};
+    rocksdb::WriteBatch batch;
+    for (uint64_t i = begin; i < end; ++i) {
+      auto status = batch.Put(keys.Key(i, &scratch), zero);
+      if (!status.ok()) {
+        throw std::runtime_error("Failed to batch key " + std::to_string(i) + ": " + status.ToString());
+      }
+      if (batch.Count() >= static_cast<int>(kPrepopulateBatchKeys) || i + 1 == end) {
+        status = db->Write(write_options, &batch);
+        if (!status.ok()) {
+          throw std::runtime_error("Failed to write prepopulation batch: " + status.ToString());
+        }
+        batch.Clear();
+      }
+    }
+  });
+}
+
+void PrepopulateWithSstFiles(rocksdb::DB* db, const rocksdb::Options& options, const KeyTable& keys,
+                             uint64_t key_space, int threads, const std::filesystem::path& staging_path) {
+  std::filesystem::remove_all(staging_path);
+  std::filesystem::create_directories(staging_path);
+  const uint64_t ranges = std::max<uint64_t>(1, std::min<uint64_t>(threads, key_space));
+  std::vector<std::string> files(ranges);
+  const std::string zero = Encode(0);
+  ForEachKeyRange(key_space, threads, [&](uint64_t range, uint64_t begin, uint64_t end) {
+    files[range] = (staging_path / ("range_" + std::to_string(range) + ".sst")).string();
+    rocksdb::SstFileWriter writer(rocksdb::EnvOptions(), options);
+    auto status = writer.Open(files[range]);
+    if (!status.ok()) {
+      throw std::runtime_error("SstFileWriter::Open failed: " + status.ToString());
+    }
+    KeyBuffer scratch{};
+    for (uint64_t i = begin; i < end; ++i) {
+      status = writer.Put(keys.Key(i, &scratch), zero);
+      if (!status.ok()) {
+        throw std::runtime_error("SstFileWriter::Put failed for key " + std::to_string(i) + ": " +
+                                 status.ToString());
+      }
+    }
+    status = writer.Finish();
     if (!status.ok()) {
-      throw std::runtime_error("Failed to prepopulate key " + std::to_string(i) + ": " + status.ToString());
+      throw std::runtime_error("SstFileWriter::Finish failed: " + status.ToString());
     }
+  });
+  rocksdb::IngestExternalFileOptions ingest_options;
+  ingest_options.move_files = true;
+  auto status = db->IngestExternalFile(files, ingest_options);
+  std::filesystem::remove_all(staging_path);
+  if (!status.ok()) {
+    throw std::runtime_error("IngestExternalFile failed: " + status.ToString());
   }
 }
 
+// Returns the wall time spent prepopulating and stores the path that actually ran in *mode.
+double Prepopulate(const Config& cfg, rocksdb::DB* db, const rocksdb::Options& options, const KeyTable& keys,
+                   const std::filesystem::path& staging_path, std::string* mode) {
+  auto start = std::chrono::steady_clock::now();
+  bool use_batches = cfg.prepopulate == "batch";
+  if (!use_batches) {
+    try {
+      PrepopulateWithSstFiles(db, options, keys, cfg.key_space, cfg.prepopulate_threads, staging_path);
+    } catch (const std::exception& ex) {
+      std::cerr << "Bulk prepopulation failed (" << ex.what() << "); falling back to WriteBatches\n";
+      use_batches = true;
+    }
+  }
+  if (use_batches) {
+    PrepopulateWithBatches(db, keys, cfg.key_space, cfg.prepopulate_threads);
+  }
+  *mode = use_batches ? "batch" : "sst";
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
 struct ThreadStats {
   uint64_t reads = 0;
   uint64_t writes = 0;
   uint64_t merge_operands = 0;
+  uint64_t retries = 0;
+  uint64_t increments = 0;  // Every committed increment, warm-up included, for verification.
+  uint64_t harness_checksum = 0;  // Keeps the null engine's key and value work observable.
+  uint64_t stale_increments = 0;
+  uint64_t stale_sum_ns = 0;
+  int64_t stale_max_ns = 0;
+  uint64_t write_ns = 0;  // Time spent applying writes, and the updates those writes carried.
+  uint64_t timed_updates = 0;
+  LatencyHistogram write_latency;  // One sample per applied write or batch.
+  LatencyHistogram hot_read_latency;
+  LatencyHistogram cold_read_latency;
+  double measured_seconds = 0.0;  // This thread's own measured window, from its first to last clock read.
+  double measured_cpu_seconds = 0.0;  // CPU time this thread used over that window.
+  uint64_t lookup_merge_operands = 0;  // This thread's PerfContext over the window.
+  uint64_t iterator_merge_operands = 0;
+
+  // Drops the warm-up's throughput and latency figures; increments and operands are kept.
+  void ResetMeasurements() {
+    reads = 0;
+    writes = 0;
+    retries = 0;
+    stale_increments = 0;
+    stale_sum_ns = 0;
+    stale_max_ns = 0;
+    write_ns = 0;
+    timed_updates = 0;
+    write_latency = LatencyHistogram();
+    hot_read_latency = LatencyHistogram();
+    cold_read_latency = LatencyHistogram();
+  }
 };
 
-ThreadStats RunWorker(rocksdb::DB* db, bool use_merge, double read_ratio, uint64_t key_space,
-                      const std::chrono::steady_clock::time_point& end_time) {
-  ThreadStats stats;
-  std::mt19937_64 rng(std::random_device{}());
-  std::uniform_real_distribution<double> action_dist(0.0, 1.0);
-  std::uniform_int_distribution<uint64_t> key_dist(0, key_space - 1);
-  rocksdb::ReadOptions read_options;
-  read_options.fill_cache = false;
-  rocksdb::WriteOptions write_options;
-  while (std::chrono::steady_clock::now() < end_time) {
-    const double pick = action_dist(rng);
-    const std::string key = std::to_string(key_dist(rng));
-    if (pick < read_ratio) {
-      std::string value;
-      auto status = db->Get(read_options, key, &value);
-      if (!status.ok() && !status.IsNotFound()) {
-        throw std::runtime_error("Read failed: " + status.ToString());
-      }
-      ++stats.reads;
+// Workers check in at the barrier and spin until RunMix publishes the phase boundaries, so no
+// thread's window includes another thread's spawn latency.
+struct PhaseClock {
+  std::atomic<int> ready{0};
+  std::atomic<bool> go{false};
+  std::chrono::steady_clock::time_point measure_start;
+  std::chrono::steady_clock::time_point end;
+};
+
+// Cumulative counts a worker publishes after every kDeadlineCheckOps operations, so RunMix can
+// sample read throughput while the mix runs. One cache line per worker.
+struct alignas(64) WorkerProgress {
+  std::atomic<uint64_t> reads{0};
+  std::atomic<uint64_t> read_ns{0};
+  std::atomic<uint64_t> increments{0};
+  std::atomic<uint64_t> merge_operands{0};
+};
+
+// Application-level locking for Strategy::kStriped: key i is guarded by mutex i % kLockStripes.
+constexpr size_t kLockStripes = 1024;
+using StripedMutexes = std::array<std::mutex, kLockStripes>;
+
+// The handles one strategy needs. db is nullptr under --null_engine; txn_db and optimistic_db
+// alias db when the strategy opened it as a TransactionDB or OptimisticTransactionDB.
+struct Engine {
+  Strategy strategy = Strategy::kMerge;
+  rocksdb::DB* db = nullptr;
+  rocksdb::TransactionDB* txn_db = nullptr;
+  rocksdb::OptimisticTransactionDB* optimistic_db = nullptr;
+  StripedMutexes* stripes = nullptr;
+  rocksdb::Statistics* statistics = nullptr;
+  rocksdb::WriteOptions write_options;  // disableWAL and sync from the write pipeline.
+  bool manual_wal_flush = false;
+};
+
+// Thread-local write-combining buffer for Strategy::kCombined: an open-addressing (linear
+// probing) map from key index to pending delta. Each slot also keeps its first increment's
+// timestamp and the sum of its increments' offsets from the oldest buffered increment, which gives
+// the exact mean and maximum time from increment to flush without storing every increment. The
+// offsets stay small, so the sums are exact integers however long the run.
+class DeltaBuffer {
+ public:
+  struct Slot {
+    uint64_t key_plus_one = 0;  // 0 marks an empty slot.
+    uint64_t delta = 0;
+    int64_t first_ns = 0;
+    uint64_t offset_sum_ns = 0;  // Sum over the slot's increments of (timestamp - OldestNs()).
+  };
+
+  explicit DeltaBuffer(size_t max_keys) {
+    size_t capacity = 16;
+    while (capacity < 2 * max_keys) {
+      capacity *= 2;
+    }
+    slots_.resize(capacity);
+    mask_ = capacity - 1;
+    used_.reserve(max_keys);
+  }
+
+  void Add(uint64_t key_index, int64_t now_ns) {
+    size_t i = static_cast<size_t>((key_index * 0x9E3779B97F4A7C15ull) >> 32) & mask_;
+    while (slots_[i].key_plus_one != 0 && slots_[i].key_plus_one != key_index + 1) {
+      i = (i + 1) & mask_;
+    }
+    Slot& slot = slots_[i];
+    if (slot.key_plus_one == 0) {
+      slot.key_plus_one = key_index + 1;
+      slot.first_ns = now_ns;
+      used_.push_back(i);
+      if (used_.size() == 1) {
+        oldest_ns_ = now_ns;
+      }
+    }
+    ++slot.delta;
+    slot.offset_sum_ns += static_cast<uint64_t>(std::max<int64_t>(0, now_ns - oldest_ns_));
+  }
+
+  size_t Size() const { return used_.size(); }
+  int64_t OldestNs() const { return oldest_ns_; }
+
+  template <typename Fn>
+  void Drain(Fn&& fn) {
+    for (size_t i : used_) {
+      fn(slots_[i]);
+      slots_[i] = Slot{};
+    }
+    used_.clear();
+  }
+
+ private:
+  std::vector<Slot> slots_;
+  std::vector<size_t> used_;
+  size_t mask_ = 0;
+  int64_t oldest_ns_ = 0;
+};
+
+double ThreadCpuSeconds() {
+  timespec ts{};
+  clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+  return static_cast<double>(ts.tv_sec) + static_cast<double>(ts.tv_nsec) / 1e9;
+}
+
+// Every thread of the process, RocksDB's background threads included.
+double ProcessCpuSeconds() {
+  timespec ts{};
+  clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+  return static_cast<double>(ts.tv_sec) + static_cast<double>(ts.tv_nsec) / 1e9;
+}
+
+int64_t SteadyNanos(std::chrono::steady_clock::time_point t) {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(t.time_since_epoch()).count();
+}
+
+// Applies one worker's increments for its strategy. Increments queue up and are applied
+// batch_size at a time: as individual Merge/Get+Put calls at 1, otherwise as one WriteBatch, with
+// RMW reads going through a single MultiGet and the transactional strategies using one
+// transaction per batch. The combined strategy ignores batch_size and uses its DeltaBuffer.
+// Every applied write or batch is timed into ThreadStats::write_latency. Updates count towards
+// ThreadStats::writes and ::increments only once applied, not while queued.
+class Updater {
+ public:
+  Updater(const Config& cfg, const Engine& engine, const KeyTable& keys, size_t batch_size, ThreadStats* stats)
+      : cfg_(cfg),
+        engine_(engine),
+        db_(engine.db),
+        keys_(keys),
+        batch_size_(std::max<size_t>(1, batch_size)),
+        stats_(stats),
+        deltas_(engine.strategy == Strategy::kCombined ? cfg.combine_keys : 0),
+        key_buffers_(batch_size_),
+        key_slices_(batch_size_),
+        values_(batch_size_),
+        statuses_(batch_size_),
+        write_options_(engine.write_options) {
+    read_options_.fill_cache = false;
+    pending_.reserve(batch_size_);
+    distinct_.reserve(batch_size_);
+    counts_.reserve(batch_size_);
+    stripe_ids_.reserve(batch_size_);
+  }
+
+  void Increment(uint64_t key_index, int64_t now_ns) {
+    if (engine_.strategy == Strategy::kCombined) {
+      deltas_.Add(key_index, now_ns);
+      if (deltas_.Size() >= cfg_.combine_keys) {
+        FlushDeltas();
+      }
+      return;
+    }
+    pending_.push_back(key_index);
+    if (pending_.size() >= batch_size_) {
+      ApplyPending();
+    }
+  }
+
+  // Time-based flush trigger for the combined strategy.
+  void Tick(int64_t now_ns) {
+    if (deltas_.Size() > 0 && now_ns - deltas_.OldestNs() >= static_cast<int64_t>(cfg_.combine_ms) * 1'000'000) {
+      FlushDeltas();
+    }
+  }
+
+  void Flush() {
+    ApplyPending();
+    FlushDeltas();
+  }
+
+ private:
+  void RecordWrite(std::chrono::steady_clock::time_point start, uint64_t updates) {
+    const auto ns = static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count());
+    stats_->write_latency.Record(ns);
+    stats_->write_ns += ns;
+    stats_->timed_updates += updates;
+  }
+
+  void ApplyPending() {
+    if (pending_.empty()) {
+      return;
+    }
+    const auto start = std::chrono::steady_clock::now();
+    const bool per_op = batch_size_ == 1 && (engine_.strategy == Strategy::kMerge ||
+                                             engine_.strategy == Strategy::kRmw ||
+                                             engine_.strategy == Strategy::kStriped);
+    if (per_op) {
+      ApplyOne(pending_.front());
     } else {
-      if (use_merge) {
-        auto status = db->Merge(write_options, key, Encode(1));
-        if (!status.ok()) {
-          throw std::runtime_error("Merge failed: " + status.ToString());
+      ApplyBatch();
+    }
+    RecordWrite(start, pending_.size());
+    stats_->writes += pending_.size();
+    stats_->increments += pending_.size();
+    pending_.clear();
+  }
+
+  void ApplyOne(uint64_t key_index) {
+    const rocksdb::Slice key = keys_.Key(key_index, &key_buffers_[0]);
+    if (engine_.strategy == Strategy::kMerge) {
+      auto status = db_->Merge(write_options_, key, Operand(1));
+      if (!status.ok()) {
+        throw std::runtime_error("Merge failed: " + status.ToString());
+      }
+      ++stats_->merge_operands;
+      return;
+    }
+    std::unique_lock<std::mutex> lock;
+    if (engine_.strategy == Strategy::kStriped) {
+      lock = std::unique_lock<std::mutex>((*engine_.stripes)[key_index % kLockStripes]);
+    }
+    auto status = db_->Get(read_options_, db_->DefaultColumnFamily(), key, &values_[0]);
+    uint64_t current = 0;
+    if (status.ok()) {
+      current = Decode(values_[0]);
+    } else if (!status.IsNotFound()) {
+      throw std::runtime_error("RMW read failed: " + status.ToString());
+    }
+    values_[0].Reset();
+    status = db_->Put(write_options_, key, Operand(current + 1));
+    if (!status.ok()) {
+      throw std::runtime_error("Put failed: " + status.ToString());
+    }
+  }
+
+  void ApplyBatch() {
+    batch_.Clear();
+    if (engine_.strategy == Strategy::kMerge) {
+      for (size_t i = 0; i < pending_.size(); ++i) {
+        AddToBatch(batch_.Merge(keys_.Key(pending_[i], &key_buffers_[i]), Operand(1)));
+      }
+      WriteCurrentBatch();
+      stats_->merge_operands += pending_.size();
+      return;
+    }
+    // Duplicate keys are collapsed so that a batch never reads a value it is about to overwrite.
+    // Sorting also gives the lock and transaction order that rules out deadlocks between workers.
+    std::sort(pending_.begin(), pending_.end());
+    distinct_.clear();
+    counts_.clear();
+    for (uint64_t key_index : pending_) {
+      if (!distinct_.empty() && distinct_.back() == key_index) {
+        ++counts_.back();
+      } else {
+        distinct_.push_back(key_index);
+        counts_.push_back(1);
+      }
+    }
+    for (size_t i = 0; i < distinct_.size(); ++i) {
+      key_slices_[i] = keys_.Key(distinct_[i], &key_buffers_[i]);
+    }
+    switch (engine_.strategy) {
+      case Strategy::kRmw:
+        ReadModifyWriteBatch();
+        break;
+      case Strategy::kStriped: {
+        stripe_ids_.clear();
+        for (uint64_t key_index : distinct_) {
+          stripe_ids_.push_back(key_index % kLockStripes);
+        }
+        std::sort(stripe_ids_.begin(), stripe_ids_.end());
+        stripe_ids_.erase(std::unique(stripe_ids_.begin(), stripe_ids_.end()), stripe_ids_.end());
+        for (size_t stripe : stripe_ids_) {
+          (*engine_.stripes)[stripe].lock();
+        }
+        try {
+          ReadModifyWriteBatch();
+        } catch (...) {
+          UnlockStripes();
+          throw;
         }
-        ++stats.merge_operands;
+        UnlockStripes();
+        break;
+      }
+      case Strategy::kTransaction:
+      case Strategy::kOptimistic:
+        TransactionalBatch();
+        break;
+      case Strategy::kMerge:
+      case Strategy::kCombined:
+        break;
+    }
+  }
+
+  void UnlockStripes() {
+    for (auto it = stripe_ids_.rbegin(); it != stripe_ids_.rend(); ++it) {
+      (*engine_.stripes)[*it].unlock();
+    }
+  }
+
+  void ReadModifyWriteBatch() {
+    const size_t n = distinct_.size();
+    db_->MultiGet(read_options_, db_->DefaultColumnFamily(), n, key_slices_.data(), values_.data(),
+                  statuses_.data(), /*sorted_input=*/true);
+    for (size_t i = 0; i < n; ++i) {
+      uint64_t current = 0;
+      if (statuses_[i].ok()) {
+        current = Decode(values_[i]);
+      } else if (!statuses_[i].IsNotFound()) {
+        throw std::runtime_error("RMW MultiGet failed: " + statuses_[i].ToString());
+      }
+      values_[i].Reset();
+      AddToBatch(batch_.Put(key_slices_[i], Operand(current + counts_[i])));
+    }
+    WriteCurrentBatch();
+  }
+
+  // One transaction covers the whole batch. Lock timeouts (pessimistic) and commit-time conflicts
+  // (optimistic) roll it back and retry it on the reused Transaction object.
+  void TransactionalBatch() {
+    for (;;) {
+      if (engine_.strategy == Strategy::kTransaction) {
+        txn_.reset(engine_.txn_db->BeginTransaction(write_options_, txn_options_, txn_.release()));
       } else {
-        std::string value;
+        txn_.reset(engine_.optimistic_db->BeginTransaction(write_options_, optimistic_options_, txn_.release()));
+      }
+      rocksdb::Status status;
+      for (size_t i = 0; i < distinct_.size() && status.ok(); ++i) {
+        status = txn_->GetForUpdate(read_options_, key_slices_[i], &txn_value_);
         uint64_t current = 0;
-        auto get_status = db->Get(read_options, key, &value);
-        if (get_status.ok()) {
-          current = Decode(rocksdb::Slice(value));
-        } else if (!get_status.IsNotFound()) {
-          throw std::runtime_error("RMW read failed: " + get_status.ToString());
+        if (status.ok()) {
+          current = Decode(txn_value_);
+        } else if (status.IsNotFound()) {
+          status = rocksdb::Status::OK();
+        } else {
+          break;
         }
-        auto status = db->Put(write_options, key, Encode(current + 1));
-        if (!status.ok()) {
-          throw std::runtime_error("Put failed: " + status.ToString());
+        status = txn_->Put(key_slices_[i], Operand(current + counts_[i]));
+      }
+      if (status.ok()) {
+        status = txn_->Commit();
+      }
+      if (status.ok()) {
+        return;
+      }
+      if (status.IsBusy() || status.IsTimedOut() || status.IsTryAgain()) {
+        txn_->Rollback();
+        ++stats_->retries;
+        continue;
+      }
+      throw std::runtime_error("Transaction failed: " + status.ToString());
+    }
+  }
+
+  // Writes every buffered delta as one Merge operand in a single WriteBatch. Staleness is charged
+  // when the batch becomes visible, i.e. after the write returns.
+  void FlushDeltas() {
+    if (deltas_.Size() == 0) {
+      return;
+    }
+    const auto start = std::chrono::steady_clock::now();
+    batch_.Clear();
+    const int64_t oldest_ns = deltas_.OldestNs();
+    uint64_t pending_offset_sum_ns = 0;
+    uint64_t pending_increments = 0;
+    int64_t first_ns = std::numeric_limits<int64_t>::max();
+    deltas_.Drain([&](const DeltaBuffer::Slot& slot) {
+      AddToBatch(batch_.Merge(keys_.Key(slot.key_plus_one - 1, &key_buffers_[0]), Operand(slot.delta)));
+      pending_offset_sum_ns += slot.offset_sum_ns;
+      pending_increments += slot.delta;
+      first_ns = std::min(first_ns, slot.first_ns);
+    });
+    WriteCurrentBatch();
+    const int64_t visible_ns = SteadyNanos(std::chrono::steady_clock::now());
+    stats_->merge_operands += static_cast<uint64_t>(batch_.Count());
+    stats_->stale_increments += pending_increments;
+    // Each increment waited from its offset after the oldest one until the batch became visible.
+    const auto since_oldest_ns = static_cast<uint64_t>(visible_ns - oldest_ns);
+    stats_->stale_sum_ns += pending_increments * since_oldest_ns - pending_offset_sum_ns;
+    stats_->stale_max_ns = std::max(stats_->stale_max_ns, visible_ns - first_ns);
+    RecordWrite(start, pending_increments);
+    stats_->writes += pending_increments;
+    stats_->increments += pending_increments;
+  }
+
+  // Encodes `value` into the operand scratch buffer. WriteBatch and DB calls copy it.
+  rocksdb::Slice Operand(uint64_t value) {
+    std::memcpy(operand_buffer_, &value, sizeof(value));
+    return rocksdb::Slice(operand_buffer_, sizeof(operand_buffer_));
+  }
+
+  static void AddToBatch(const rocksdb::Status& status) {
+    if (!status.ok()) {
+      throw std::runtime_error("WriteBatch update failed: " + status.ToString());
+    }
+  }
+
+  void WriteCurrentBatch() {
+    auto status = db_->Write(write_options_, &batch_);
+    if (!status.ok()) {
+      throw std::runtime_error("Batched write failed: " + status.ToString());
+    }
+  }
+
+  const Config& cfg_;
+  const Engine& engine_;
+  rocksdb::DB* db_;
+  const KeyTable& keys_;
+  const size_t batch_size_;
+  ThreadStats* stats_;
+  DeltaBuffer deltas_;
+  rocksdb::ReadOptions read_options_;
+  rocksdb::WriteBatch batch_;
+  std::vector<uint64_t> pending_;
+  std::vector<uint64_t> distinct_;
+  std::vector<uint64_t> counts_;
+  std::vector<size_t> stripe_ids_;
+  std::vector<KeyBuffer> key_buffers_;
+  std::vector<rocksdb::Slice> key_slices_;
+  std::vector<rocksdb::PinnableSlice> values_;
+  std::vector<rocksdb::Status> statuses_;
+  const rocksdb::WriteOptions write_options_;
+  std::unique_ptr<rocksdb::Transaction> txn_;
+  std::string txn_value_;
+  const rocksdb::TransactionOptions txn_options_;
+  const rocksdb::OptimisticTransactionOptions optimistic_options_;
+  char operand_buffer_[sizeof(uint64_t)];
+};
+
+// The clock is read once per kDeadlineCheckOps operations, so a worker overshoots its deadline
+// by at most that many operations. Operations before clock.measure_start are warm-up and are
+// discarded; the measured window runs from the first clock read past it to the last one.
+constexpr uint64_t kDeadlineCheckOps = 64;
+
+// With engine.db == nullptr (--null_engine) every RocksDB call is skipped but keys and RNG draws
+// are still produced, which measures what the harness itself costs per operation.
+ThreadStats RunWorker(const Config& cfg, const Engine& engine, const KeyTable& keys, const KeySampler& sampler,
+                      double read_ratio, size_t batch_size, PhaseClock& clock, WorkerProgress& progress) {
+  ThreadStats stats;
+  rocksdb::DB* db = engine.db;
+  FastRng rng(std::random_device{}() ^ (static_cast<uint64_t>(std::random_device{}()) << 32));
+  const uint64_t read_threshold = ProbabilityThreshold(read_ratio);
+  rocksdb::ReadOptions read_options;
+  read_options.fill_cache = false;
+  KeyBuffer key_buffer{};
+  rocksdb::PinnableSlice value;
+  Updater updater(cfg, engine, keys, batch_size, &stats);
+
+  // PerfContext is thread-local; counting costs an increment per event, with no timers.
+  if (cfg.merge_stats) {
+    rocksdb::SetPerfLevel(rocksdb::PerfLevel::kEnableCount);
+  }
+  clock.ready.fetch_add(1, std::memory_order_acq_rel);
+  while (!clock.go.load(std::memory_order_acquire)) {
+    std::this_thread::yield();
+  }
+  bool measuring = false;
+  std::chrono::steady_clock::time_point window_start;
+  double window_cpu_start = 0.0;
+  uint64_t total_reads = 0;  // Unlike stats.reads, not reset at the end of the warm-up.
+  uint64_t total_read_ns = 0;
+  for (;;) {
+    progress.reads.store(total_reads, std::memory_order_relaxed);
+    progress.read_ns.store(total_read_ns, std::memory_order_relaxed);
+    progress.increments.store(stats.increments, std::memory_order_relaxed);
+    progress.merge_operands.store(stats.merge_operands, std::memory_order_relaxed);
+    const auto now = std::chrono::steady_clock::now();
+    const int64_t now_ns = SteadyNanos(now);
+    if (!measuring && now >= clock.measure_start) {
+      stats.ResetMeasurements();
+      window_start = now;
+      window_cpu_start = ThreadCpuSeconds();
+      rocksdb::get_perf_context()->Reset();
+      measuring = true;
+    }
+    if (db != nullptr) {
+      updater.Tick(now_ns);
+    }
+    if (now >= clock.end) {
+      if (db != nullptr) {
+        updater.Flush();
+      }
+      stats.measured_seconds = std::chrono::duration<double>(now - window_start).count();
+      stats.measured_cpu_seconds = ThreadCpuSeconds() - window_cpu_start;
+      if (cfg.merge_stats) {
+        const rocksdb::PerfContext* perf = rocksdb::get_perf_context();
+        stats.lookup_merge_operands = perf->internal_merge_point_lookup_count;
+        stats.iterator_merge_operands = perf->internal_merge_count;
+        rocksdb::SetPerfLevel(rocksdb::PerfLevel::kDisable);
+      }
+      break;
+    }
+    for (uint64_t op = 0; op < kDeadlineCheckOps; ++op) {
+      const bool is_read = rng.Next() < read_threshold;
+      const uint64_t key_index = sampler.Next(rng);
+      if (db == nullptr) {
+        const rocksdb::Slice key = keys.Key(key_index, &key_buffer);
+        stats.harness_checksum += key.size() + static_cast<uint8_t>(key[0]);
+        if (is_read) {
+          ++stats.reads;
+        } else {
+          ++stats.writes;
         }
+        continue;
+      }
+      if (is_read) {
+        const int64_t read_start_ns = cfg.time_reads ? SteadyNanos(std::chrono::steady_clock::now()) : 0;
+        auto status = db->Get(read_options, db->DefaultColumnFamily(), keys.Key(key_index, &key_buffer), &value);
+        if (!status.ok() && !status.IsNotFound()) {
+          throw std::runtime_error("Read failed: " + status.ToString());
+        }
+        if (cfg.time_reads) {
+          const auto read_ns =
+              static_cast<uint64_t>(SteadyNanos(std::chrono::steady_clock::now()) - read_start_ns);
+          (sampler.IsHot(key_index) ? stats.hot_read_latency : stats.cold_read_latency).Record(read_ns);
+          total_read_ns += read_ns;
+        }
+        value.Reset();
+        ++stats.reads;
+        ++total_reads;
+      } else {
+        updater.Increment(key_index, now_ns);
       }
-      ++stats.writes;
     }
   }
   return stats;
 }
 
-std::vector<Metrics> RunPhase(const Config& cfg, rocksdb::DB* db, bool use_merge,
-                              const std::vector<Workload>& workloads) {
-  std::vector<Metrics> metrics;
-  metrics.reserve(workloads.size());
-  for (const auto& workload : workloads) {
-    std::vector<std::thread> threads;
-    std::vector<ThreadStats> thread_stats(cfg.threads);
-    auto end_time = std::chrono::steady_clock::now() + std::chrono::seconds(cfg.seconds_per_phase);
-    for (int t = 0; t < cfg.threads; ++t) {
-      threads.emplace_back([&, t]() {
-        thread_stats[t] = RunWorker(db, use_merge, workload.read_ratio, cfg.key_space, end_time);
-      });
-    }
-    for (auto& th : threads) {
-      th.join();
-    }
-    uint64_t total_reads = 0;
-    uint64_t total_writes = 0;
-    uint64_t total_merge_ops = 0;
-    for (const auto& s : thread_stats) {
-      total_reads += s.reads;
-      total_writes += s.writes;
-      total_merge_ops += s.merge_operands;
-    }
-    const double seconds = static_cast<double>(cfg.seconds_per_phase);
-    double merge_ops_per_key = use_merge && cfg.key_space > 0
-                                   ? static_cast<double>(total_merge_ops) /
-                                         static_cast<double>(cfg.key_space)
-                                   : 0.0;
-    metrics.push_back(Metrics{total_reads / seconds, total_writes / seconds, merge_ops_per_key});
+Metrics RunMix(const Config& cfg, const Engine& engine, const KeyTable& keys, const KeySampler& sampler,
+               const Workload& workload, int thread_count, size_t batch_size, uint64_t* increments) {
+  std::vector<std::thread> threads;
+  std::vector<ThreadStats> thread_stats(thread_count);
+  std::vector<WorkerProgress> progress(thread_count);
+  PhaseClock clock;
+  for (int t = 0; t < thread_count; ++t) {
+    threads.emplace_back([&, t]() {
+      thread_stats[t] = RunWorker(cfg, engine, keys, sampler, workload.read_ratio, batch_size, clock, progress[t]);
+    });
+  }
+  while (clock.ready.load(std::memory_order_acquire) < thread_count) {
+    std::this_thread::yield();
   }
+  clock.measure_start = std::chrono::steady_clock::now() + std::chrono::seconds(cfg.warmup_seconds);
+  clock.end = clock.measure_start + std::chrono::seconds(cfg.seconds_per_phase);
+  clock.go.store(true, std::memory_order_release);
+  // With manual_wal_flush the WAL sits in RocksDB's buffer until FlushWAL, so a background thread
+  // flushes it every wal_flush_ms, syncing when the pipeline asks for sync.
+  std::atomic<bool> workers_done{false};
+  std::thread wal_flusher;
+  if (engine.manual_wal_flush && engine.db != nullptr) {
+    wal_flusher = std::thread([&]() {
+      while (!workers_done.load(std::memory_order_acquire)) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(cfg.wal_flush_ms));
+        auto status = engine.db->FlushWAL(engine.write_options.sync);
+        if (!status.ok()) {
+          std::cerr << "FlushWAL failed: " << status.ToString() << "\n";
+        }
+      }
+    });
+  }
+  // Under --steady_state, sample once a second through the measured window: throughput and mean Get
+  // latency over the interval, the operand depth reached by its end, and the LSM shape and write
+  // stalls behind them.
+  std::vector<IntervalSample> series;
+  if (engine.db != nullptr) {
+    struct Totals {
+      uint64_t reads = 0;
+      uint64_t read_ns = 0;
+      uint64_t increments = 0;
+      uint64_t operands = 0;
+      uint64_t stall_micros = 0;
+    };
+    auto read_totals = [&]() {
+      Totals totals;
+      for (const auto& p : progress) {
+        totals.reads += p.reads.load(std::memory_order_relaxed);
+        totals.read_ns += p.read_ns.load(std::memory_order_relaxed);
+        totals.increments += p.increments.load(std::memory_order_relaxed);
+        totals.operands += p.merge_operands.load(std::memory_order_relaxed);
+      }
+      if (engine.statistics != nullptr) {
+        totals.stall_micros = engine.statistics->getTickerCount(rocksdb::STALL_MICROS);
+      }
+      return totals;
+    };
+    std::this_thread::sleep_until(clock.measure_start);
+    if (engine.statistics != nullptr) {
+      engine.statistics->Reset();  // Drop the warm-up's tickers and histograms.
+    }
+    auto last_time = std::chrono::steady_clock::now();
+    Totals last = read_totals();
+    while (cfg.steady_state && last_time + std::chrono::seconds(1) <= clock.end) {
+      std::this_thread::sleep_until(last_time + std::chrono::seconds(1));
+      const auto now = std::chrono::steady_clock::now();
+      const Totals totals = read_totals();
+      const double interval = std::chrono::duration<double>(now - last_time).count();
+      IntervalSample sample;
+      sample.seconds = std::chrono::duration<double>(now - clock.measure_start).count();
+      sample.merge_ops_per_key = static_cast<double>(totals.operands) / static_cast<double>(cfg.key_space);
+      sample.read_ops_per_sec = static_cast<double>(totals.reads - last.reads) / interval;
+      sample.write_ops_per_sec = static_cast<double>(totals.increments - last.increments) / interval;
+      if (cfg.time_reads) {
+        sample.avg_get_us = totals.reads > last.reads ? static_cast<double>(totals.read_ns - last.read_ns) /
+                                                            static_cast<double>(totals.reads - last.reads) / 1000.0
+                                                      : 0.0;
+      }
+      sample.stall_ms = static_cast<double>(totals.stall_micros - last.stall_micros) / 1000.0;
+      engine.db->GetIntProperty("rocksdb.num-files-at-level0", &sample.l0_files);
+      engine.db->GetIntProperty("rocksdb.estimate-pending-compaction-bytes", &sample.pending_compaction_bytes);
+      series.push_back(sample);
+      last_time = now;
+      last = totals;
+    }
+  }
+  for (auto& th : threads) {
+    th.join();
+  }
+  workers_done.store(true, std::memory_order_release);
+  if (wal_flusher.joinable()) {
+    wal_flusher.join();
+  }
+  // Each thread's rate comes from its own measured window; the phase rate is their sum.
+  Metrics metrics;
+  metrics.mix = workload.name;
+  metrics.threads = thread_count;
+  metrics.batch_size = batch_size;
+  metrics.key_dist = sampler.name();
+  metrics.merge_stats = cfg.merge_stats;
+  metrics.series = std::move(series);
+  uint64_t total_merge_ops = 0;
+  uint64_t total_writes = 0;
+  uint64_t total_retries = 0;
+  uint64_t stale_increments = 0;
+  uint64_t stale_sum_ns = 0;
+  uint64_t write_ns = 0;
+  uint64_t timed_updates = 0;
+  uint64_t measured_ops = 0;
+  double cpu_seconds = 0.0;
+  LatencyHistogram write_latency;
+  *increments = 0;
+  for (const auto& s : thread_stats) {
+    const double seconds = std::max(1e-9, s.measured_seconds);
+    metrics.read_ops_per_sec += static_cast<double>(s.reads) / seconds;
+    metrics.write_ops_per_sec += static_cast<double>(s.writes) / seconds;
+    total_merge_ops += s.merge_operands;
+    total_writes += s.writes;
+    total_retries += s.retries;
+    *increments += s.increments;
+    stale_increments += s.stale_increments;
+    stale_sum_ns += s.stale_sum_ns;
+    metrics.max_staleness_ms = std::max(metrics.max_staleness_ms, static_cast<double>(s.stale_max_ns) / 1e6);
+    write_ns += s.write_ns;
+    timed_updates += s.timed_updates;
+    write_latency.Merge(s.write_latency);
+    measured_ops += s.reads + s.writes;
+    metrics.measured_increments += s.writes;
+    metrics.lookup_merge_operands += s.lookup_merge_operands;
+    metrics.iterator_merge_operands += s.iterator_merge_operands;
+    cpu_seconds += s.measured_cpu_seconds;
+    metrics.hot_read_latency.Merge(s.hot_read_latency);
+    metrics.cold_read_latency.Merge(s.cold_read_latency);
+  }
+  metrics.avg_merge_ops_per_key = cfg.key_space > 0
+                                      ? static_cast<double>(total_merge_ops) /
+                                            static_cast<double>(cfg.key_space)
+                                      : 0.0;
+  metrics.retry_rate = total_writes > 0 ? static_cast<double>(total_retries) / static_cast<double>(total_writes)
+                                        : 0.0;
+  metrics.avg_staleness_ms =
+      stale_increments > 0 ? static_cast<double>(stale_sum_ns) / static_cast<double>(stale_increments) / 1e6 : 0.0;
+  metrics.write_us_per_update =
+      timed_updates > 0 ? static_cast<double>(write_ns) / static_cast<double>(timed_updates) / 1000.0 : 0.0;
+  metrics.p99_write_us = write_latency.PercentileUs(99.0);
+  if (engine.statistics != nullptr) {
+    metrics.merge_time_ns = engine.statistics->getTickerCount(rocksdb::MERGE_OPERATION_TOTAL_TIME);
+    engine.statistics->histogramData(rocksdb::READ_NUM_MERGE_OPERANDS, &metrics.operands_per_get);
+  }
+  metrics.worker_cpu_seconds = cpu_seconds;
+  if (engine.statistics != nullptr) {
+    metrics.background_compaction_cpu_seconds =
+        static_cast<double>(engine.statistics->getTickerCount(rocksdb::COMPACTION_CPU_TOTAL_TIME)) / 1e6;
+  }
+  metrics.cpu_us_per_op = measured_ops > 0 ? cpu_seconds / static_cast<double>(measured_ops) * 1e6 : 0.0;
   return metrics;
 }
 
-void PrintResults(const std::string& title, const std::vector<Metrics>& metrics,
-                  const std::vector<Workload>& workloads) {
+// What the verification scan learns about the counters. Every counter starts at zero and each
+// increment adds one, so a counter's value is the number of updates its key received: exactly its
+// merge operand depth for the per-op and batched Merge strategies, an upper bound for kCombined.
+constexpr size_t kTopKeys = 5;
+
+struct CounterScan {
+  uint64_t sum = 0;
+  uint64_t max_per_key = 0;
+  uint64_t p99_per_key = 0;
+  std::vector<std::pair<std::string, uint64_t>> top_keys;  // Highest counters first.
+};
+
+// Sums every counter with a full scan. Merge operands are folded in by the iterator. The top keys
+// are kept in a kTopKeys-entry min-heap as the scan passes, and the p99 comes from a fixed-size
+// log histogram, so the scan's memory does not grow with the key space.
+CounterScan ScanCounters(rocksdb::DB* db, uint64_t key_space) {
+  rocksdb::ReadOptions read_options;
+  read_options.fill_cache = false;
+  read_options.readahead_size = 2 * 1024 * 1024;
+  read_options.total_order_seek = true;  // The hash memtables only iterate in key order when asked.
+  std::unique_ptr<rocksdb::Iterator> it(db->NewIterator(read_options));
+  CounterScan scan;
+  uint64_t counters = 0;
+  LatencyHistogram per_key;
+  auto by_count = [](const std::pair<std::string, uint64_t>& a, const std::pair<std::string, uint64_t>& b) {
+    return a.second > b.second;
+  };
+  for (it->SeekToFirst(); it->Valid(); it->Next()) {
+    const uint64_t value = Decode(it->value());
+    scan.sum += value;
+    scan.max_per_key = std::max(scan.max_per_key, value);
+    per_key.Record(value);
+    ++counters;
+    if (scan.top_keys.size() < kTopKeys || value > scan.top_keys.front().second) {
+      if (scan.top_keys.size() == kTopKeys) {
+        std::pop_heap(scan.top_keys.begin(), scan.top_keys.end(), by_count);
+        scan.top_keys.pop_back();
+      }
+      scan.top_keys.emplace_back(it->key().ToString(), value);
+      std::push_heap(scan.top_keys.begin(), scan.top_keys.end(), by_count);
+    }
+  }
+  if (!it->status().ok()) {
+    throw std::runtime_error("Verification scan failed: " + it->status().ToString());
+  }
+  if (counters != key_space) {
+    throw std::runtime_error("Verification scan found " + std::to_string(counters) + " counters, expected " +
+                             std::to_string(key_space));
+  }
+  std::sort_heap(scan.top_keys.begin(), scan.top_keys.end(), by_count);
+  scan.p99_per_key = std::min(scan.max_per_key, static_cast<uint64_t>(std::llround(per_key.Percentile(99.0))));
+  return scan;
+}
+
+// Merge defers work that RMW does at write time. This pays the rest of it: flush the memtable and
+// compact the whole key range, which folds every operand into its base value. No workers are
+// running, so the process CPU time over the call is RocksDB's flush and compaction threads.
+CompactionCost FlushAndCompactAll(rocksdb::DB* db, rocksdb::Statistics* statistics) {
+  CompactionCost cost;
+  const uint64_t bytes_before = statistics->getTickerCount(rocksdb::FLUSH_WRITE_BYTES) +
+                                statistics->getTickerCount(rocksdb::COMPACT_WRITE_BYTES);
+  const double cpu_before = ProcessCpuSeconds();
+  const auto start = std::chrono::steady_clock::now();
+  auto status = db->Flush(rocksdb::FlushOptions());
+  if (!status.ok()) {
+    throw std::runtime_error("Flush after mix failed: " + status.ToString());
+  }
+  rocksdb::CompactRangeOptions compact_options;
+  compact_options.bottommost_level_compaction = rocksdb::BottommostLevelCompaction::kForceOptimized;
+  status = db->CompactRange(compact_options, nullptr, nullptr);
+  if (!status.ok()) {
+    throw std::runtime_error("CompactRange after mix failed: " + status.ToString());
+  }
+  cost.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  cost.cpu_seconds = ProcessCpuSeconds() - cpu_before;
+  cost.bytes_written = statistics->getTickerCount(rocksdb::FLUSH_WRITE_BYTES) +
+                       statistics->getTickerCount(rocksdb::COMPACT_WRITE_BYTES) - bytes_before;
+  return cost;
+}
+
+// Recreates `target` from the checkpoint. SST files are immutable, so they are hard-linked and the
+// restore costs the same for any key space; the small MANIFEST, CURRENT, OPTIONS and WAL files are
+// copied because the reopened DB may append to them.
+double RestoreCheckpoint(const std::filesystem::path& checkpoint_path, const std::filesystem::path& target) {
+  auto start = std::chrono::steady_clock::now();
+  if (std::filesystem::exists(target)) {
+    std::filesystem::remove_all(target);
+  }
+  std::filesystem::create_directories(target);
+  for (const auto& entry : std::filesystem::directory_iterator(checkpoint_path)) {
+    const auto destination = target / entry.path().filename();
+    if (entry.path().extension() == ".sst") {
+      std::filesystem::create_hard_link(entry.path(), destination);
+    } else {
+      std::filesystem::copy_file(entry.path(), destination);
+    }
+  }
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+// The columns that identify a run, shared by the per-strategy tables.
+void PrintRunHeader() {
+  std::cout << std::setw(10) << "Mix" << std::setw(9) << "Threads" << std::setw(7) << "Batch"
+            << std::setw(18) << "Pipeline" << std::setw(22) << "Memtable" << std::setw(20) << "Dist"
+            << std::setw(12) << "Collapse";
+}
+
+void PrintRunColumns(const Metrics& m) {
+  std::cout << std::setw(10) << m.mix << std::setw(9) << m.threads << std::setw(7) << m.batch_size
+            << std::setw(18) << m.pipeline << std::setw(22) << m.memtable << std::setw(20) << m.key_dist
+            << std::setw(12) << m.collapse;
+}
+
+// Staleness columns are printed only for the write-combined strategy, the one that defers writes.
+void PrintResults(const std::string& title, const std::vector<Metrics>& metrics, bool show_staleness) {
   std::cout << "== " << title << " ==\n";
-  std::cout << std::setw(10) << "Mix" << std::setw(15) << "Reads/s" << std::setw(15) << "Writes/s"
-            << std::setw(20) << "Merge Ops/Key" << "\n";
-  for (std::size_t i = 0; i < workloads.size(); ++i) {
-    std::cout << std::setw(10) << workloads[i].name
-              << std::setw(15) << std::llround(metrics[i].read_ops_per_sec)
+  PrintRunHeader();
+  std::cout << std::setw(15) << "Reads/s" << std::setw(15) << "Writes/s"
+            << std::setw(12) << "us/Update" << std::setw(13) << "p99 Write us"
+            << std::setw(20) << "Merge Ops/Key" << std::setw(10) << "Retry %" << std::setw(12) << "Lost"
+            << std::setw(12) << "Restore s";
+  if (show_staleness) {
+    std::cout << std::setw(14) << "Avg Stale ms" << std::setw(14) << "Max Stale ms";
+  }
+  std::cout << "\n";
+  for (std::size_t i = 0; i < metrics.size(); ++i) {
+    PrintRunColumns(metrics[i]);
+    std::cout << std::setw(15) << std::llround(metrics[i].read_ops_per_sec)
               << std::setw(15) << std::llround(metrics[i].write_ops_per_sec)
-              << std::setw(20) << std::fixed << std::setprecision(2) << metrics[i].avg_merge_ops_per_key
-              << "\n";
+              << std::setw(12) << std::fixed << std::setprecision(2) << metrics[i].write_us_per_update
+              << std::setw(13) << metrics[i].p99_write_us
+              << std::setw(20) << metrics[i].avg_merge_ops_per_key
+              << std::setw(10) << 100.0 * metrics[i].retry_rate
+              << std::setw(12) << metrics[i].lost_updates
+              << std::setw(12) << std::setprecision(3) << metrics[i].restore_seconds;
+    if (show_staleness) {
+      std::cout << std::setw(14) << std::setprecision(2) << metrics[i].avg_staleness_ms
+                << std::setw(14) << metrics[i].max_staleness_ms;
+    }
+    std::cout << "\n";
+  }
+}
+
+// One row per sampled second of every mix: how Get slows as operands pile up and, in steady
+// state, as L0 files and compaction debt build up and are worked off.
+void PrintTimeSeries(const std::string& title, const std::vector<Metrics>& metrics) {
+  std::cout << "== " << title << ": per-second series ==\n";
+  PrintRunHeader();
+  std::cout << std::setw(10) << "Second" << std::setw(15) << "Ops/Key" << std::setw(15) << "Reads/s"
+            << std::setw(15) << "Writes/s" << std::setw(12) << "Get us" << std::setw(10) << "L0 Files"
+            << std::setw(14) << "Pending MB" << std::setw(12) << "Stall ms" << "\n";
+  for (const auto& m : metrics) {
+    for (const auto& sample : m.series) {
+      PrintRunColumns(m);
+      std::cout << std::setw(10) << std::fixed << std::setprecision(1) << sample.seconds
+                << std::setw(15) << std::setprecision(2) << sample.merge_ops_per_key
+                << std::setw(15) << std::llround(sample.read_ops_per_sec)
+                << std::setw(15) << std::llround(sample.write_ops_per_sec)
+                << std::setw(12);
+      if (sample.avg_get_us >= 0.0) {
+        std::cout << sample.avg_get_us;
+      } else {
+        std::cout << "-";
+      }
+      std::cout << std::setw(10) << sample.l0_files
+                << std::setw(14) << static_cast<double>(sample.pending_compaction_bytes) / (1024.0 * 1024.0)
+                << std::setw(12) << sample.stall_ms << "\n";
+    }
   }
 }
 
-void RunBenchmark(const Config& cfg, bool use_merge, const std::vector<Workload>& workloads) {
-  const std::filesystem::path db_path = cfg.db_root / (use_merge ? "merge" : "rmw");
-  if (std::filesystem::exists(db_path)) {
-    std::filesystem::remove_all(db_path);
+// Per-key update counts from the verification scan, and Get latency split between the
+// distribution's hot keys and the rest. The latency columns show "-" when reads were not timed.
+void PrintKeySkew(const std::string& title, const std::vector<Metrics>& metrics) {
+  std::cout << "== " << title << ": key skew ==\n";
+  PrintRunHeader();
+  std::cout << std::setw(12) << "Max/Key" << std::setw(12) << "p99/Key"
+            << std::setw(12) << "Hot p50" << std::setw(12) << "Hot p99" << std::setw(12) << "Hot p99.9"
+            << std::setw(12) << "Cold p50" << std::setw(12) << "Cold p99" << std::setw(12) << "Cold p99.9"
+            << "  Top keys\n";
+  for (const auto& m : metrics) {
+    PrintRunColumns(m);
+    std::cout << std::setw(12) << m.max_increments_per_key << std::setw(12) << m.p99_increments_per_key
+              << std::fixed << std::setprecision(2);
+    const bool timed = m.hot_read_latency.Count() + m.cold_read_latency.Count() > 0;
+    for (const LatencyHistogram* latency : {&m.hot_read_latency, &m.cold_read_latency}) {
+      for (double percentile : {50.0, 99.0, 99.9}) {
+        if (timed) {
+          std::cout << std::setw(12) << latency->PercentileUs(percentile);
+        } else {
+          std::cout << std::setw(12) << "-";
+        }
+      }
+    }
+    std::cout << " ";
+    for (const auto& [key, count] : m.top_keys) {
+      std::cout << " " << key << ":" << count;
+    }
+    std::cout << "\n";
   }
-  std::filesystem::create_directories(cfg.db_root);
-  rocksdb::Options options = BuildOptions(use_merge);
+}
+
+// Read-side merge cost measured by RocksDB itself rather than estimated from the writes.
+void PrintMergeAccounting(const std::string& title, const std::vector<Metrics>& metrics) {
+  std::cout << "== " << title << ": merge accounting ==\n";
+  PrintRunHeader();
+  std::cout << std::setw(16) << "Lookup Merges" << std::setw(14) << "Iter Merges" << std::setw(12) << "Merge ms"
+            << std::setw(14) << "Merge ns/Get" << std::setw(12) << "Ops/Get" << std::setw(12) << "p50 Ops"
+            << std::setw(12) << "p99 Ops" << std::setw(12) << "Max Ops" << "\n";
+  for (const auto& m : metrics) {
+    const rocksdb::HistogramData& ops = m.operands_per_get;
+    PrintRunColumns(m);
+    std::cout << std::setw(16) << m.lookup_merge_operands << std::setw(14) << m.iterator_merge_operands
+              << std::setw(12) << std::fixed << std::setprecision(2) << static_cast<double>(m.merge_time_ns) / 1e6
+              << std::setw(14)
+              << (ops.count > 0 ? static_cast<double>(m.merge_time_ns) / static_cast<double>(ops.count) : 0.0)
+              << std::setw(12) << ops.average << std::setw(12) << ops.median << std::setw(12) << ops.percentile99
+              << std::setw(12) << ops.max << "\n";
+  }
+}
+
+// CPU per increment, write + read + compaction. The workers' CPU over the measured window is
+// spread over the increments made in it; compaction CPU, in the window and after the mix, is
+// spread over every increment the mix made, warm-up included, since it folds all of them.
+// The after-mix columns are net of `baseline`, the same step on the untouched checkpoint.
+void PrintDeferredCost(const std::string& title, const std::vector<Metrics>& metrics,
+                       const CompactionCost& baseline) {
+  std::cout << "== " << title << ": deferred cost ==\n";
+  std::cout << "Baseline flush + compaction of the restored checkpoint: " << std::fixed << std::setprecision(3)
+            << baseline.seconds << " s, " << baseline.cpu_seconds << " CPU s, " << std::setprecision(1)
+            << static_cast<double>(baseline.bytes_written) / (1024.0 * 1024.0)
+            << " MB written; subtracted below\n";
+  PrintRunHeader();
+  std::cout << std::setw(12) << "Compact s" << std::setw(14) << "Compact CPU s" << std::setw(14) << "MB Written"
+            << std::setw(16) << "Worker us/Incr" << std::setw(16) << "Compact us/Incr" << std::setw(14)
+            << "Total us/Incr" << "\n";
+  for (const auto& m : metrics) {
+    const double compact_seconds = std::max(0.0, m.compact.seconds - baseline.seconds);
+    const double compact_cpu_seconds = std::max(0.0, m.compact.cpu_seconds - baseline.cpu_seconds);
+    const uint64_t compact_bytes =
+        m.compact.bytes_written > baseline.bytes_written ? m.compact.bytes_written - baseline.bytes_written : 0;
+    const double worker_us = m.measured_increments > 0
+                                 ? m.worker_cpu_seconds / static_cast<double>(m.measured_increments) * 1e6
+                                 : 0.0;
+    const double compact_us =
+        m.total_increments > 0
+            ? (m.background_compaction_cpu_seconds + compact_cpu_seconds) / static_cast<double>(m.total_increments) *
+                  1e6
+            : 0.0;
+    PrintRunColumns(m);
+    std::cout << std::setw(12) << std::fixed << std::setprecision(3) << compact_seconds
+              << std::setw(14) << compact_cpu_seconds
+              << std::setw(14) << std::setprecision(1) << static_cast<double>(compact_bytes) / (1024.0 * 1024.0)
+              << std::setw(16) << std::setprecision(3) << worker_us << std::setw(16) << compact_us
+              << std::setw(14) << worker_us + compact_us << "\n";
+  }
+}
+
+// What write-time collapsing buys: write and read throughput against the deepest merge chain a
+// Get had to fold, per --max_successive_merges setting. The chain depths need merge statistics,
+// which a sweep of more than one setting always collects.
+void PrintCollapse(const std::string& title, const std::vector<Metrics>& metrics) {
+  std::cout << "== " << title << ": write-time collapsing ==\n";
+  PrintRunHeader();
+  std::cout << std::setw(15) << "Writes/s" << std::setw(13) << "p99 Write us" << std::setw(15) << "Reads/s"
+            << std::setw(12) << "Ops/Get" << std::setw(12) << "Max Ops" << "\n";
+  for (const auto& m : metrics) {
+    PrintRunColumns(m);
+    std::cout << std::setw(15) << std::llround(m.write_ops_per_sec)
+              << std::setw(13) << std::fixed << std::setprecision(2) << m.p99_write_us
+              << std::setw(15) << std::llround(m.read_ops_per_sec);
+    if (m.merge_stats) {
+      std::cout << std::setw(12) << m.operands_per_get.average << std::setw(12) << m.operands_per_get.max << "\n";
+    } else {
+      std::cout << std::setw(12) << "-" << std::setw(12) << "-" << "\n";
+    }
+  }
+}
+
+// ns/op is per thread: the time one worker spends generating and dispatching an operation.
+void PrintHarnessResults(const std::vector<Metrics>& metrics) {
+  std::cout << "== Null engine (harness only) ==\n";
+  std::cout << std::setw(10) << "Mix" << std::setw(9) << "Threads" << std::setw(15) << "Ops/s"
+            << std::setw(15) << "ns/op" << "\n";
+  for (const auto& m : metrics) {
+    const double ops_per_sec = m.read_ops_per_sec + m.write_ops_per_sec;
+    std::cout << std::setw(10) << m.mix << std::setw(9) << m.threads
+              << std::setw(15) << std::llround(ops_per_sec)
+              << std::setw(15) << std::fixed << std::setprecision(2)
+              << (ops_per_sec > 0.0 ? 1e9 * m.threads / ops_per_sec : 0.0) << "\n";
+  }
+}
+
+void RunNullEngine(const Config& cfg, const KeyTable& keys, const std::vector<KeySampler>& samplers,
+                   const std::vector<Workload>& workloads) {
+  std::vector<Metrics> metrics;
+  const Engine engine;
+  for (int threads : cfg.thread_counts) {
+    for (const auto& sampler : samplers) {
+      for (const auto& workload : workloads) {
+        uint64_t increments = 0;
+        metrics.push_back(RunMix(cfg, engine, keys, sampler, workload, threads, /*batch_size=*/1, &increments));
+      }
+    }
+  }
+  PrintHarnessResults(metrics);
+}
+
+std::unique_ptr<rocksdb::DB> OpenDB(const rocksdb::Options& options, const std::filesystem::path& db_path) {
   rocksdb::DB* raw_db = nullptr;
   auto status = rocksdb::DB::Open(options, db_path.string(), &raw_db);
   if (!status.ok()) {
-    throw std::runtime_error("Failed to open DB: " + status.ToString());
+    throw std::runtime_error("Failed to open DB at " + db_path.string() + ": " + status.ToString());
+  }
+  return std::unique_ptr<rocksdb::DB>(raw_db);
+}
+
+// Opens db_path the way `strategy` needs it and fills in engine's handles. The open status is
+// returned rather than thrown so the caller can tell an option combination RocksDB rejects from a
+// real failure.
+rocksdb::Status OpenForStrategy(const rocksdb::Options& base_options, const std::filesystem::path& db_path,
+                                Strategy strategy, const WritePipeline& pipeline, Engine* engine,
+                                std::unique_ptr<rocksdb::DB>* db) {
+  engine->strategy = strategy;
+  engine->write_options.disableWAL = pipeline.disable_wal;
+  engine->write_options.sync = pipeline.sync && !pipeline.manual_wal_flush;
+  engine->manual_wal_flush = pipeline.manual_wal_flush && !pipeline.disable_wal;
+  rocksdb::Options options = base_options;
+  options.manual_wal_flush = pipeline.manual_wal_flush;
+  options.enable_pipelined_write = pipeline.pipelined;
+  options.unordered_write = pipeline.unordered;
+  options.two_write_queues = pipeline.two_write_queues;
+  options.allow_concurrent_memtable_write =
+      base_options.allow_concurrent_memtable_write && pipeline.concurrent_memtable;
+  rocksdb::Status status;
+  if (strategy == Strategy::kTransaction) {
+    rocksdb::TransactionDB* raw_db = nullptr;
+    status = rocksdb::TransactionDB::Open(options, rocksdb::TransactionDBOptions(), db_path.string(), &raw_db);
+    engine->txn_db = raw_db;
+    db->reset(raw_db);
+  } else if (strategy == Strategy::kOptimistic) {
+    rocksdb::OptimisticTransactionDB* raw_db = nullptr;
+    status = rocksdb::OptimisticTransactionDB::Open(options, db_path.string(), &raw_db);
+    engine->optimistic_db = raw_db;
+    db->reset(raw_db);
+  } else {
+    rocksdb::DB* raw_db = nullptr;
+    status = rocksdb::DB::Open(options, db_path.string(), &raw_db);
+    db->reset(raw_db);
+  }
+  engine->db = db->get();
+  engine->statistics = options.statistics.get();
+  return status;
+}
+
+// The prepopulated DB is flushed and checkpointed once; every mix then runs on its own restore
+// of that checkpoint, so no mix inherits the operands of the one before it.
+void RunBenchmark(const Config& cfg, const KeyTable& keys, const std::vector<KeySampler>& samplers, Strategy strategy,
+                  const std::vector<Workload>& workloads) {
+  const std::string name = StrategyName(strategy);
+  const std::filesystem::path base_path = cfg.db_root / (name + "_base");
+  const std::filesystem::path checkpoint_path = cfg.db_root / (name + "_checkpoint");
+  const std::filesystem::path db_path = cfg.db_root / name;
+  for (const auto& path : {base_path, checkpoint_path, db_path}) {
+    if (std::filesystem::exists(path)) {
+      std::filesystem::remove_all(path);
+    }
+  }
+  std::filesystem::create_directories(cfg.db_root);
+  const bool uses_merge = strategy == Strategy::kMerge || strategy == Strategy::kCombined;
+  rocksdb::Options options = BuildOptions(uses_merge, cfg.steady_state);
+  {
+    std::unique_ptr<rocksdb::DB> db = OpenDB(options, base_path);
+    std::string mode;
+    const double prepopulate_seconds =
+        Prepopulate(cfg, db.get(), options, keys, cfg.db_root / (name + "_staging"), &mode);
+    std::cout << "[" << name << "] prepopulated " << cfg.key_space << " keys in " << std::fixed
+              << std::setprecision(2) << prepopulate_seconds << "s (" << mode << ", "
+              << cfg.prepopulate_threads << " threads)\n";
+    auto status = db->Flush(rocksdb::FlushOptions());
+    if (!status.ok()) {
+      throw std::runtime_error("Flush after prepopulation failed: " + status.ToString());
+    }
+    rocksdb::Checkpoint* raw_checkpoint = nullptr;
+    status = rocksdb::Checkpoint::Create(db.get(), &raw_checkpoint);
+    if (!status.ok()) {
+      throw std::runtime_error("Checkpoint::Create failed: " + status.ToString());
+    }
+    std::unique_ptr<rocksdb::Checkpoint> checkpoint(raw_checkpoint);
+    status = checkpoint->CreateCheckpoint(checkpoint_path.string());
+    if (!status.ok()) {
+      throw std::runtime_error("CreateCheckpoint failed: " + status.ToString());
+    }
+  }
+  std::filesystem::remove_all(base_path);
+
+  options.error_if_exists = false;
+  // The restored checkpoint alone already costs something to flush and compact. Measure that once,
+  // with no mix on top, so the deferred cost table can report only what a mix added.
+  CompactionCost baseline;
+  if (cfg.deferred_cost) {
+    RestoreCheckpoint(checkpoint_path, db_path);
+    const rocksdb::Options baseline_options = WithStatistics(options, /*merge_stats=*/false);
+    std::unique_ptr<rocksdb::DB> db = OpenDB(baseline_options, db_path);
+    baseline = FlushAndCompactAll(db.get(), baseline_options.statistics.get());
   }
-  std::unique_ptr<rocksdb::DB> db(raw_db);
-  Prepopulate(db.get(), cfg.key_space);
-  auto metrics = RunPhase(cfg, db.get(), use_merge, workloads);
-  PrintResults(use_merge ? "Merge" : "Read-Modify-Write", metrics, workloads);
-  db.reset();
   std::filesystem::remove_all(db_path);
+  // The write-combined strategy has its own buffer, so a batch-size sweep would only repeat it.
+  const std::vector<size_t> batch_sizes =
+      strategy == Strategy::kCombined ? std::vector<size_t>{1} : cfg.write_batch_sizes;
+  // Only a merge operator has operands to collapse.
+  const std::vector<MergeCollapse> collapses =
+      uses_merge ? cfg.merge_collapses : std::vector<MergeCollapse>{MergeCollapse{}};
+  // Comparing collapse settings needs the operand depth per Get, so a sweep always collects it.
+  Config mix_cfg = cfg;
+  mix_cfg.merge_stats = cfg.merge_stats || collapses.size() > 1;
+  std::vector<Metrics> metrics;
+  // Pipeline/memtable/collapse combinations RocksDB refused to open. The refusal does not depend on
+  // the threads, batch size, sampler or mix, so each is opened, and reported, only once.
+  std::set<std::string> rejected;
+  for (int threads : cfg.thread_counts) {
+    for (size_t batch_size : batch_sizes) {
+      for (const auto& pipeline : cfg.write_pipelines) {
+        for (const auto& memtable : cfg.memtables) {
+          rocksdb::Options mix_options = options;
+          ApplyMemtable(memtable, keys.width(), cfg.key_space, &mix_options);
+          for (const auto& collapse : collapses) {
+            rocksdb::Options run_options = mix_options;
+            run_options.max_successive_merges = collapse.max_successive_merges;
+            run_options.strict_max_successive_merges = collapse.strict;
+            const std::string combination = pipeline.name + "/" + memtable.name + "/" + collapse.name;
+            if (rejected.count(combination) > 0) {
+              continue;
+            }
+            for (const auto& sampler : samplers) {
+              if (rejected.count(combination) > 0) {
+                break;
+              }
+              for (const auto& workload : workloads) {
+                const double restore_seconds = RestoreCheckpoint(checkpoint_path, db_path);
+                Engine engine;
+                auto stripes = std::make_unique<StripedMutexes>();
+                engine.stripes = stripes.get();
+                std::unique_ptr<rocksdb::DB> db;
+                const auto status = OpenForStrategy(WithStatistics(run_options, mix_cfg.merge_stats), db_path, strategy,
+                                                    pipeline, &engine, &db);
+                if (status.IsInvalidArgument() || status.IsNotSupported()) {
+                  // Some combinations are rejected at open, e.g. unordered_write with pipelined writes or
+                  // with TransactionDB's default write policy. Record the skip and keep sweeping.
+                  std::cerr << "[" << name << "] skipping pipeline " << pipeline.name << " with memtable "
+                            << memtable.name << " and max_successive_merges " << collapse.name << ": "
+                            << status.ToString() << "\n";
+                  std::filesystem::remove_all(db_path);
+                  rejected.insert(combination);
+                  break;
+                }
+                if (!status.ok()) {
+                  throw std::runtime_error("Failed to open " + name + " DB at " + db_path.string() + ": " +
+                                           status.ToString());
+                }
+                uint64_t increments = 0;
+                metrics.push_back(RunMix(mix_cfg, engine, keys, sampler, workload, threads, batch_size, &increments));
+                metrics.back().pipeline = pipeline.name;
+                metrics.back().memtable = memtable.name;
+                metrics.back().collapse = collapse.name;
+                metrics.back().restore_seconds = restore_seconds;
+                metrics.back().total_increments = increments;
+                if (cfg.deferred_cost) {
+                  metrics.back().compact = FlushAndCompactAll(db.get(), engine.statistics);
+                }
+                // Every counter started at zero, so the counters must sum to the increments that were applied.
+                CounterScan scan = ScanCounters(db.get(), cfg.key_space);
+                const uint64_t sum = scan.sum;
+                metrics.back().max_increments_per_key = scan.max_per_key;
+                metrics.back().p99_increments_per_key = scan.p99_per_key;
+                metrics.back().top_keys = std::move(scan.top_keys);
+                metrics.back().lost_updates = static_cast<int64_t>(increments) - static_cast<int64_t>(sum);
+                if (strategy != Strategy::kRmw && metrics.back().lost_updates != 0) {
+                  throw std::runtime_error(std::string("Verification failed for ") + StrategyName(strategy) + " " +
+                                           workload.name + ": counters sum to " + std::to_string(sum) + " after " +
+                                           std::to_string(increments) + " increments");
+                }
+                db.reset();
+                std::filesystem::remove_all(db_path);
+              }
+            }
+          }
+        }
+      }
+    }
+  }
+  PrintResults(StrategyTitle(strategy), metrics, strategy == Strategy::kCombined);
+  if (cfg.steady_state) {
+    PrintTimeSeries(StrategyTitle(strategy), metrics);
+  }
+  if (HasSkewedKeyDistribution(cfg)) {
+    PrintKeySkew(StrategyTitle(strategy), metrics);
+  }
+  if (cfg.merge_stats) {
+    PrintMergeAccounting(StrategyTitle(strategy), metrics);
+  }
+  if (cfg.deferred_cost) {
+    PrintDeferredCost(StrategyTitle(strategy), metrics, baseline);
+  }
+  if (uses_merge) {
+    PrintCollapse(StrategyTitle(strategy), metrics);
+  }
+  std::filesystem::remove_all(checkpoint_path);
+}
+
+// The operand-depth sweep (--depths) preloads exactly D Merge operands of 1 on every one of
+// --depth_keys counters, placed in one of three ways, then runs a read-only phase on it:
+//   memtable: the operands stay in a memtable sized to hold them all;
+//   l0:       the memtable is flushed, leaving the operands in L0;
+//   levels:   the operands are split into kDepthLevels shares, the oldest moved into L5, the next
+//             into L4 and so on, with the newest share left in L0.
+// The base values sit in the bottommost level below all of them. Compactions that do not include
+// the base cannot fold the operands (PartialMerge is disabled), so every Get merges exactly D.
+constexpr int kDepthLevels = 6;
+constexpr uint64_t kDepthBytesPerOperand = 96;  // Memtable bytes per operand, key and skiplist node included.
+
+struct DepthPoint {
+  std::string placement;
+  uint64_t depth = 0;
+  double load_seconds = 0.0;
+  std::string layout;  // SST files per level after loading, e.g. "L0:1 L6:8".
+  Metrics metrics;
+};
+
+// Appends `rounds` operands to every key, round by round, so each key's operands are interleaved
+// with the other keys' as they would be in a live workload.
+void LoadOperandRounds(rocksdb::DB* db, const KeyTable& keys, uint64_t key_space, uint64_t rounds, int threads) {
+  rocksdb::WriteOptions write_options;
+  write_options.disableWAL = true;
+  const std::string one = Encode(1);
+  ForEachKeyRange(key_space, threads, [&](uint64_t, uint64_t begin, uint64_t end) {
+    KeyBuffer scratch{};
+    rocksdb::WriteBatch batch;
+    for (uint64_t round = 0; round < rounds; ++round) {
+      for (uint64_t i = begin; i < end; ++i) {
+        auto status = batch.Merge(keys.Key(i, &scratch), one);
+        if (!status.ok()) {
+          throw std::runtime_error("Failed to batch operand for key " + std::to_string(i) + ": " + status.ToString());
+        }
+        if (batch.Count() >= static_cast<int>(kPrepopulateBatchKeys)) {
+          status = db->Write(write_options, &batch);
+          if (!status.ok()) {
+            throw std::runtime_error("Failed to write operand batch: " + status.ToString());
+          }
+          batch.Clear();
+        }
+      }
+    }
+    if (batch.Count() > 0) {
+      auto status = db->Write(write_options, &batch);
+      if (!status.ok()) {
+        throw std::runtime_error("Failed to write operand batch: " + status.ToString());
+      }
+    }
+  });
+}
+
+void FlushOrThrow(rocksdb::DB* db) {
+  auto status = db->Flush(rocksdb::FlushOptions());
+  if (!status.ok()) {
+    throw std::runtime_error("Flush failed: " + status.ToString());
+  }
+}
+
+// Compacts every L0 file, and only those, into `level`.
+void MoveL0To(rocksdb::DB* db, int level) {
+  rocksdb::ColumnFamilyMetaData meta;
+  db->GetColumnFamilyMetaData(&meta);
+  std::vector<std::string> files;
+  for (const auto& file : meta.levels.at(0).files) {
+    files.push_back(file.name);
+  }
+  if (files.empty()) {
+    return;
+  }
+  auto status = db->CompactFiles(rocksdb::CompactionOptions(), files, level);
+  if (!status.ok()) {
+    throw std::runtime_error("CompactFiles into L" + std::to_string(level) + " failed: " + status.ToString());
+  }
+}
+
+std::string DescribeLayout(rocksdb::DB* db) {
+  rocksdb::ColumnFamilyMetaData meta;
+  db->GetColumnFamilyMetaData(&meta);
+  std::string layout;
+  for (const auto& level : meta.levels) {
+    if (!level.files.empty()) {
+      layout += (layout.empty() ? "L" : " L") + std::to_string(level.level) + ":" + std::to_string(level.files.size());
+    }
+  }
+  return layout.empty() ? "-" : layout;
+}
+
+void PrintDepthCurve(const std::vector<DepthPoint>& points) {
+  std::cout << "== Get cost vs merge operand depth ==\n";
+  std::cout << std::setw(10) << "Placement" << std::setw(8) << "Depth" << std::setw(16) << "Layout"
+            << std::setw(9) << "Threads" << std::setw(15) << "Gets/s" << std::setw(12) << "p50 us"
+            << std::setw(12) << "p99 us" << std::setw(12) << "p99.9 us" << std::setw(14) << "CPU us/Get"
+            << std::setw(10) << "Ops/Get"
+            << std::setw(10) << "Load s" << "\n";
+  for (const auto& point : points) {
+    LatencyHistogram latency = point.metrics.hot_read_latency;
+    latency.Merge(point.metrics.cold_read_latency);
+    std::cout << std::setw(10) << point.placement << std::setw(8) << point.depth << std::setw(16) << point.layout
+              << std::setw(9) << point.metrics.threads
+              << std::setw(15) << std::llround(point.metrics.read_ops_per_sec)
+              << std::setw(12) << std::fixed << std::setprecision(2) << latency.PercentileUs(50.0)
+              << std::setw(12) << latency.PercentileUs(99.0) << std::setw(12) << latency.PercentileUs(99.9)
+              << std::setw(14) << point.metrics.cpu_us_per_op
+              << std::setw(10) << point.metrics.operands_per_get.average
+              << std::setw(10) << point.load_seconds << "\n";
+  }
+}
+
+void RunDepthSweep(const Config& cfg) {
+  Config depth_cfg = cfg;
+  depth_cfg.key_space = cfg.depth_keys;
+  depth_cfg.merge_stats = true;  // Ops/Get is how the sweep checks the depth it loaded.
+  const KeyTable keys(depth_cfg.key_space);
+  const KeySampler sampler(KeyDistribution{}, depth_cfg.key_space);
+  const Workload read_only{"read-only", 1.0};
+  const std::filesystem::path db_path = cfg.db_root / "depth";
+  std::filesystem::create_directories(cfg.db_root);
+  std::vector<DepthPoint> points;
+  for (const auto& placement : cfg.depth_placements) {
+    for (uint64_t depth : cfg.depths) {
+      std::filesystem::remove_all(db_path);
+      rocksdb::Options options = BuildOptions(/*use_merge=*/true, /*steady_state=*/false);
+      options.write_buffer_size = std::max<size_t>(
+          options.write_buffer_size, static_cast<size_t>(2 * depth_cfg.key_space * depth * kDepthBytesPerOperand));
+      // Loading may leave many L0 files behind with auto compactions off; never stall on them.
+      options.level0_slowdown_writes_trigger = 1 << 30;
+      options.level0_stop_writes_trigger = 1 << 30;
+      options = WithStatistics(options, /*merge_stats=*/true);
+      std::unique_ptr<rocksdb::DB> db = OpenDB(options, db_path);
+      std::string mode;
+      Prepopulate(depth_cfg, db.get(), options, keys, cfg.db_root / "depth_staging", &mode);
+      FlushOrThrow(db.get());
+      rocksdb::CompactRangeOptions to_bottom;
+      to_bottom.change_level = true;
+      to_bottom.target_level = options.num_levels - 1;
+      auto status = db->CompactRange(to_bottom, nullptr, nullptr);
+      if (!status.ok()) {
+        throw std::runtime_error("Moving the base values to the bottommost level failed: " + status.ToString());
+      }
+
+      const auto load_start = std::chrono::steady_clock::now();
+      if (placement == "memtable") {
+        LoadOperandRounds(db.get(), keys, depth_cfg.key_space, depth, cfg.prepopulate_threads);
+      } else if (placement == "l0") {
+        LoadOperandRounds(db.get(), keys, depth_cfg.key_space, depth, cfg.prepopulate_threads);
+        FlushOrThrow(db.get());
+      } else {
+        // Deeper levels get the older operands and any remainder.
+        for (int share = 0; share < kDepthLevels; ++share) {
+          const int level = kDepthLevels - 1 - share;
+          const uint64_t rounds = depth / kDepthLevels + (static_cast<uint64_t>(share) < depth % kDepthLevels ? 1 : 0);
+          if (rounds == 0) {
+            continue;
+          }
+          LoadOperandRounds(db.get(), keys, depth_cfg.key_space, rounds, cfg.prepopulate_threads);
+          FlushOrThrow(db.get());
+          if (level > 0) {
+            MoveL0To(db.get(), level);
+          }
+        }
+      }
+      const double load_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - load_start).count();
+      const std::string layout = DescribeLayout(db.get());
+      std::cout << "[depth] " << placement << " depth " << depth << ": loaded in " << std::fixed
+                << std::setprecision(2) << load_seconds << "s (" << layout << ")\n";
+
+      Engine engine;
+      engine.db = db.get();
+      engine.statistics = options.statistics.get();
+      for (int threads : cfg.thread_counts) {
+        uint64_t increments = 0;
+        DepthPoint point;
+        point.placement = placement;
+        point.depth = depth;
+        point.load_seconds = load_seconds;
+        point.layout = layout;
+        point.metrics = RunMix(depth_cfg, engine, keys, sampler, read_only, threads, /*batch_size=*/1, &increments);
+        points.push_back(std::move(point));
+      }
+      const uint64_t sum = ScanCounters(db.get(), depth_cfg.key_space).sum;
+      if (sum != depth_cfg.key_space * depth) {
+        throw std::runtime_error("Depth " + std::to_string(depth) + " (" + placement + ") counters sum to " +
+                                 std::to_string(sum) + ", expected " + std::to_string(depth_cfg.key_space * depth));
+      }
+      db.reset();
+      std::filesystem::remove_all(db_path);
+    }
+  }
+  PrintDepthCurve(points);
 }
 
 Config ParseArguments(int argc, char** argv) {
@@ -262,19 +2311,84 @@ Config ParseArguments(int argc, char** argv) {
     } else if (arg.rfind("--keys=", 0) == 0) {
       cfg.key_space = std::stoull(arg.substr(std::string("--keys=").size()));
     } else if (arg.rfind("--threads=", 0) == 0) {
-      cfg.threads = std::stoi(arg.substr(std::string("--threads=").size()));
+      cfg.thread_counts = ParseCounts<int>(arg.substr(std::string("--threads=").size()), "--threads");
+    } else if (arg.rfind("--write_batch_size=", 0) == 0) {
+      cfg.write_batch_sizes =
+          ParseCounts<size_t>(arg.substr(std::string("--write_batch_size=").size()), "--write_batch_size");
+    } else if (arg.rfind("--write_pipeline=", 0) == 0) {
+      cfg.write_pipelines = ParseWritePipelines(arg.substr(std::string("--write_pipeline=").size()));
+    } else if (arg.rfind("--wal_flush_ms=", 0) == 0) {
+      cfg.wal_flush_ms = std::stoi(arg.substr(std::string("--wal_flush_ms=").size()));
+      if (cfg.wal_flush_ms <= 0) {
+        throw std::runtime_error("--wal_flush_ms must be positive");
+      }
+    } else if (arg.rfind("--memtable=", 0) == 0) {
+      cfg.memtables = ParseMemtables(arg.substr(std::string("--memtable=").size()));
+    } else if (arg.rfind("--key_dist=", 0) == 0) {
+      cfg.key_dists = ParseKeyDistributions(arg.substr(std::string("--key_dist=").size()));
+    } else if (arg.rfind("--depths=", 0) == 0) {
+      cfg.depths = ParseCounts<uint64_t>(arg.substr(std::string("--depths=").size()), "--depths");
+    } else if (arg.rfind("--depth_placement=", 0) == 0) {
+      cfg.depth_placements = SplitCsv(arg.substr(std::string("--depth_placement=").size()));
+      for (const auto& placement : cfg.depth_placements) {
+        if (placement != "memtable" && placement != "l0" && placement != "levels") {
+          throw std::runtime_error("Unknown depth placement: " + placement);
+        }
+      }
+      if (cfg.depth_placements.empty()) {
+        throw std::runtime_error("--depth_placement needs at least one entry");
+      }
+    } else if (arg.rfind("--depth_keys=", 0) == 0) {
+      cfg.depth_keys = std::stoull(arg.substr(std::string("--depth_keys=").size()));
+      if (cfg.depth_keys == 0) {
+        throw std::runtime_error("--depth_keys must be positive");
+      }
+    } else if (arg.rfind("--max_successive_merges=", 0) == 0) {
+      cfg.merge_collapses = ParseMergeCollapses(arg.substr(std::string("--max_successive_merges=").size()));
     } else if (arg.rfind("--seconds=", 0) == 0) {
       cfg.seconds_per_phase = std::stoi(arg.substr(std::string("--seconds=").size()));
+    } else if (arg.rfind("--warmup_seconds=", 0) == 0) {
+      cfg.warmup_seconds = std::stoi(arg.substr(std::string("--warmup_seconds=").size()));
     } else if (arg.rfind("--mix=", 0) == 0) {
       cfg.mix_filter = arg.substr(std::string("--mix=").size());
+    } else if (arg.rfind("--prepopulate=", 0) == 0) {
+      cfg.prepopulate = arg.substr(std::string("--prepopulate=").size());
+      if (cfg.prepopulate != "sst" && cfg.prepopulate != "batch") {
+        throw std::runtime_error("Unknown prepopulation mode: " + cfg.prepopulate);
+      }
+    } else if (arg.rfind("--prepopulate_threads=", 0) == 0) {
+      cfg.prepopulate_threads = std::max(1, std::stoi(arg.substr(std::string("--prepopulate_threads=").size())));
+    } else if (arg.rfind("--strategies=", 0) == 0) {
+      cfg.strategies = ParseStrategies(arg.substr(std::string("--strategies=").size()));
+    } else if (arg.rfind("--combine_keys=", 0) == 0) {
+      cfg.combine_keys = std::max<size_t>(1, std::stoull(arg.substr(std::string("--combine_keys=").size())));
+    } else if (arg.rfind("--combine_ms=", 0) == 0) {
+      cfg.combine_ms = std::stoi(arg.substr(std::string("--combine_ms=").size()));
+    } else if (arg == "--steady_state") {
+      cfg.steady_state = true;
+    } else if (arg == "--null_engine") {
+      cfg.null_engine = true;
+    } else if (arg == "--merge_stats") {
+      cfg.merge_stats = true;
+    } else if (arg == "--deferred_cost") {
+      cfg.deferred_cost = true;
     } else if (arg == "--help" || arg == "-h") {
-      std::cout << "Usage: merge_bench [--db_root=dir] [--keys=N] [--threads=N] [--seconds=N] [--mix=ratio]\n";
+      std::cout << "Usage: merge_bench [--db_root=dir] [--keys=N] [--threads=csv] [--write_batch_size=csv] [--seconds=N]"
+                   " [--warmup_seconds=N] [--mix=ratio] [--null_engine] [--prepopulate=sst|batch]"
+                   " [--prepopulate_threads=N] [--strategies=rmw,striped,txn,optimistic,merge,combined]"
+                   " [--combine_keys=N] [--combine_ms=N] [--write_pipeline=csv] [--wal_flush_ms=N]"
+                   " [--memtable=csv] [--key_dist=csv] [--depths=csv] [--depth_placement=csv]"
+                   " [--depth_keys=N] [--steady_state] [--max_successive_merges=csv] [--merge_stats]"
+                   " [--deferred_cost]\n";
       std::exit(EXIT_SUCCESS);
     } else {
       std::cerr << "Unknown argument: " << arg << "\n";
       std::exit(EXIT_FAILURE);
     }
   }
+  // Timing a Get costs two clock reads, so reads are timed only for the tables that show it: the
+  // hot/cold split of a skewed distribution, the steady-state Get us series and the depth sweep.
+  cfg.time_reads = !cfg.depths.empty() || cfg.steady_state || HasSkewedKeyDistribution(cfg);
   return cfg;
 }
 
@@ -283,9 +2397,26 @@ Config ParseArguments(int argc, char** argv) {
 int main(int argc, char** argv) {
   try {
     Config cfg = ParseArguments(argc, argv);
+    if (cfg.key_space == 0) {
+      throw std::runtime_error("--keys must be positive");
+    }
     auto workloads = SelectWorkloads(cfg.mix_filter);
-    RunBenchmark(cfg, /*use_merge=*/false, workloads);
-    RunBenchmark(cfg, /*use_merge=*/true, workloads);
+    const KeyTable keys(cfg.key_space);
+    std::vector<KeySampler> samplers;
+    for (const auto& dist : cfg.key_dists) {
+      samplers.emplace_back(dist, cfg.key_space);
+    }
+    if (!cfg.depths.empty()) {
+      RunDepthSweep(cfg);
+      return EXIT_SUCCESS;
+    }
+    if (cfg.null_engine) {
+      RunNullEngine(cfg, keys, samplers, workloads);
+      return EXIT_SUCCESS;
+    }
+    for (Strategy strategy : cfg.strategies) {
+      RunBenchmark(cfg, keys, samplers, strategy, workloads);
+    }
   } catch (const std::exception& ex) {
     std::cerr << "Error: " << ex.what() << "\n";
     return EXIT_FAILURE;